@@ -0,0 +1,84 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define NSLOT 512
+
+static uint seed = 1;
+static char *slots[NSLOT];
+
+static uint rand(void) {
+    seed = seed * 1103515245 + 12345;
+    return seed >> 16;
+}
+
+// Free every live slot.
+static void clear(void) {
+    int i;
+
+    for(i = 0; i < NSLOT; i++) {
+        free(slots[i]);
+        slots[i] = 0;
+    }
+}
+
+// Allocate and immediately free one size, n times.
+static int same(int n, uint size) {
+    int start, i;
+    char *p;
+
+    start = uptime();
+    for(i = 0; i < n; i++) {
+        if((p = malloc(size)) == 0)
+            return -1;
+        p[0] = 0;
+        free(p);
+    }
+    return uptime() - start;
+}
+
+// Toggle random slots between free and a random size in
+// [min, min+range), so the heap holds a shifting mix of blocks.
+static int churn(int n, uint nslot, uint min, uint range) {
+    int start, i, j;
+
+    start = uptime();
+    for(i = 0; i < n; i++) {
+        j = rand() % nslot;
+        if(slots[j]) {
+            free(slots[j]);
+            slots[j] = 0;
+        } else if((slots[j] = malloc(min + rand() % range)) == 0) {
+            return -1;
+        } else {
+            slots[j][0] = 0;
+        }
+    }
+    clear();
+    return uptime() - start;
+}
+
+static void report(char *name, int ticks) {
+    if(ticks < 0)
+        printf(1, "%s\tout of memory\n", name);
+    else
+        printf(1, "%s\t%d ticks\n", name, ticks);
+}
+
+int main(int argc, char* argv[]) {
+    int n;
+
+    n = argc > 1 ? atoi(argv[1]) : 100000;
+    if(n < 1) {
+        printf(2, "usage: allocbench [iterations]\n");
+        exit();
+    }
+
+    report("same 32", same(n, 32));
+    report("same 1000", same(n, 1000));
+    report("small", churn(n, NSLOT, 8, 248));
+    report("mixed", churn(n, NSLOT, 8, 4000));
+    report("large", churn(n / 10, 16, 4096, 28672));
+    malloc_stats();
+    exit();
+}
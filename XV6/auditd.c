@@ -0,0 +1,67 @@
+#include "types.h"
+#include "param.h"
+#include "stat.h"
+#include "date.h"
+#include "fcntl.h"
+#include "user.h"
+#include "trace.h"
+
+// Audit daemon, started by init.  Appends the system calls the
+// kernel audits for logged-in users to AUDITLOG as struct
+// auditrecs, moving it to AUDITOLD once it reaches AUDITMAX bytes.
+
+#define NREC 64
+
+static int fd, size;
+
+static void openlog(void) {
+    if((fd = open(AUDITLOG, O_CREATE | O_WRONLY)) < 0) {
+        printf(2, "auditd: cannot open %s\n", AUDITLOG);
+        exit();
+    }
+    size = lseek(fd, 0, SEEK_END);
+}
+
+static void rotate(void) {
+    close(fd);
+    unlink(AUDITOLD);
+    if(link(AUDITLOG, AUDITOLD) < 0 || unlink(AUDITLOG) < 0)
+        printf(2, "auditd: cannot move %s to %s\n", AUDITLOG, AUDITOLD);
+    openlog();
+}
+
+int main(void) {
+    static struct tracerec recs[NREC];
+    static struct auditrec out[NREC + 1];
+    struct rtcdate now;
+    uint lost, time;
+    int i, n, m;
+
+    openlog();
+    for(;;) {
+        if((n = auditread(recs, NREC, &lost)) < 0)
+            exit();
+        get_system_time(&now);
+        time = AUDITTIME(&now);
+        m = 0;
+        if(lost) {
+            out[m].time = time;
+            out[m].uid = -1;
+            out[m].ret = lost;
+            out[m].pid = 0;
+            out[m].num = AUDIT_LOST;
+            m++;
+        }
+        for(i = 0; i < n; i++, m++) {
+            out[m].time = time;
+            out[m].uid = recs[i].uid;
+            out[m].ret = recs[i].ret;
+            out[m].pid = recs[i].pid;
+            out[m].num = recs[i].num;
+        }
+        if(size + m * sizeof(out[0]) > AUDITMAX)
+            rotate();
+        if(write(fd, out, m * sizeof(out[0])) == m * sizeof(out[0]))
+            size += m * sizeof(out[0]);
+    }
+}
@@ -40,7 +40,7 @@ binit(void)
 {
   struct buf *b;
 
-  initlock(&bcache.lock, "bcache");
+  initticketlock(&bcache.lock, "bcache");
 
 //PAGEBREAK!
   // Create linked list of buffers
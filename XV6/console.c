@@ -16,6 +16,7 @@
 #include "x86.h"
 
 static void consputc(int);
+static void cgaflush(void);
 
 static int panicked = 0;
 
@@ -225,6 +226,7 @@ cprintf(char *fmt, ...)
       break;
     }
   }
+  cgaflush();
 
   if(locking)
     release(&cons.lock);
@@ -255,24 +257,41 @@ panic(char *s)
 #define CRTPORT 0x3d4
 static ushort *crt = (ushort*)P2V(0xb8000);  // CGA memory
 
-static void
-cgaputc(int c)
+// The cursor position (col + 80*row) is kept in cgapos and
+// only written to the CRT controller by cgaflush(), once per
+// cprintf, consolewrite or keyboard interrupt, instead of
+// being read and written with four port accesses per character.
+static int cgapos;
+static int cgashown;  // Position last written to the controller
+
+static int
+cgareadcursor(void)
 {
   int pos;
 
-  // Cursor position: col + 80*row.
   outb(CRTPORT, 14);
   pos = inb(CRTPORT+1) << 8;
   outb(CRTPORT, 15);
   pos |= inb(CRTPORT+1);
+  return pos;
+}
 
-  if(c == '\n')
-    pos += 80 - pos%80;
-  else if(c == BACKSPACE){
-    if(pos > 0) --pos;
-  } else
-    crt[pos++] = (c&0xff) | 0x0700;  // black on white
+static void
+cgaflush(void)
+{
+  if(cgapos == cgashown)
+    return;
+  outb(CRTPORT, 14);
+  outb(CRTPORT+1, cgapos>>8);
+  outb(CRTPORT, 15);
+  outb(CRTPORT+1, cgapos);
+  cgashown = cgapos;
+}
 
+// Scroll up if pos is past the last line; return the new pos.
+static int
+cgascroll(int pos)
+{
   // Check if pos is out of the screen.
   if(pos < 0 || pos > 25*80)
     panic("pos under/overflow");
@@ -282,29 +301,55 @@ cgaputc(int c)
     pos -= 80;
     memset(crt+pos, 0, sizeof(crt[0])*(24*80 - pos));
   }
+  return pos;
+}
 
-  outb(CRTPORT, 14);
-  outb(CRTPORT+1, pos>>8);
-  outb(CRTPORT, 15);
-  outb(CRTPORT+1, pos);
+static void
+cgaputc(int c)
+{
+  int pos = cgapos;
+
+  if(c == '\n')
+    pos += 80 - pos%80;
+  else if(c == BACKSPACE){
+    if(pos > 0) --pos;
+  } else
+    crt[pos++] = (c&0xff) | 0x0700;  // black on white
+
+  pos = cgascroll(pos);
+  cgapos = pos;
+  crt[pos] = ' ' | 0x0700;
+}
+
+// Write n bytes to the screen.  Runs of ordinary characters
+// are stored straight into CGA memory, a line at a time.
+static void
+cgawrite(char *buf, int n)
+{
+  int i, pos, c;
+
+  pos = cgapos;
+  for(i = 0; i < n; i++){
+    c = buf[i] & 0xff;
+    if(c == '\n')
+      pos += 80 - pos%80;
+    else
+      crt[pos++] = c | 0x0700;
+    if(pos % 80 == 0)
+      pos = cgascroll(pos);
+  }
+  cgapos = pos;
   crt[pos] = ' ' | 0x0700;
 }
 
 void move_cursor(int dir)
 {
-  outb(CRTPORT, 14);
-  int pos = inb(CRTPORT+1) << 8;
-  outb(CRTPORT, 15);
-  pos |= inb(CRTPORT+1);
+  int pos = cgapos;
 
   pos += dir;
   if (pos < 0) pos = 0;
   if (pos > 80*25 - 1) pos = 80*25 - 1;
-
-  outb(CRTPORT, 14);
-  outb(CRTPORT+1, pos >> 8);
-  outb(CRTPORT, 15);
-  outb(CRTPORT+1, pos);
+  cgapos = pos;
 }
 
 void
@@ -584,7 +629,7 @@ consoleintr(int (*getc)(void))
       break;
     }
   }
-
+  cgaflush();
 
   release(&cons.lock);
   if(doprocdump) {
@@ -635,27 +680,47 @@ consoleread(struct inode *ip, char *dst, int n)
 int
 consolewrite(struct inode *ip, char *buf, int n)
 {
-  int i;
+  int i, m;
   iunlock(ip);
   acquire(&cons.lock);
   
-  if(strlen(buf) == 1 && buf[0] == special_tab_char){
+  // buf is not NUL-terminated: only n bytes are valid.
+  if(n == 1 && buf[0] == special_tab_char){
     release(&cons.lock);
     ilock(ip);
     return n;
   }
 
-  if(is_tab_context && strlen(buf) > 0 && buf[0] == special_tab_char){  
+  if(is_tab_context && n > 0 && buf[0] == special_tab_char){  
     for(i = 1; i < n; i++)
       insert_char(buf[i] & 0xff , 1);
     // debug_input_buffer();
     is_tab_context = 0;
   }
   else{
-    for(i = 0; i < n; i++)
-      consputc(buf[i] & 0xff);
+    if(panicked){
+      cli();
+      for(;;)
+        ;
+    }
+    // Each piece goes to the screen and into the serial ring
+    // under cons.lock, so concurrent writers come out in the
+    // same order on both.  Only waiting for the UART to drain
+    // a full ring happens without the lock.
+    for(i = 0; ; i += m){
+      m = uartqueue(buf + i, n - i);
+      cgawrite(buf + i, m);
+      if(i + m == n)
+        break;
+      cgaflush();
+      release(&cons.lock);
+      uartwait();
+      acquire(&cons.lock);
+    }
   }
+  cgaflush();
   release(&cons.lock);
+  uartstart();
   ilock(ip);
 
   return n;
@@ -664,7 +729,9 @@ consolewrite(struct inode *ip, char *buf, int n)
 void
 consoleinit(void)
 {
-  initlock(&cons.lock, "console");
+  initticketlock(&cons.lock, "console");
+
+  cgapos = cgashown = cgareadcursor();
 
   devsw[CONSOLE].write = consolewrite;
   devsw[CONSOLE].read = consoleread;
@@ -748,12 +815,7 @@ uchar getRainbowColor(int offset) {
 
 // Color functions
 void consputc_color(int c, uchar color) {
-  int pos;
-
-  outb(CRTPORT, 14);
-  pos = inb(CRTPORT+1) << 8;
-  outb(CRTPORT, 15);
-  pos |= inb(CRTPORT+1);
+  int pos = cgapos;
 
   if(c == '\n')
     pos += 80 - pos % 80;
@@ -765,11 +827,7 @@ void consputc_color(int c, uchar color) {
     pos -= 80;
     memset(crt + pos, 0, sizeof(crt[0]) * (24 * 80 - pos));
   }
-
-  outb(CRTPORT, 14);
-  outb(CRTPORT+1, pos >> 8);
-  outb(CRTPORT, 15);
-  outb(CRTPORT+1, pos);
+  cgapos = pos;
 }
 
 // Mathematical functions
@@ -915,18 +973,10 @@ void debugPrintBuffer(void) {
 }
 
 void move_cursor_to_line_start(void) {
-  outb(CRTPORT, 14);
-  int pos = inb(CRTPORT + 1) << 8;
-  outb(CRTPORT, 15);
-  pos |= inb(CRTPORT + 1);
+  int pos = cgapos;
 
   // jump to start of current line
   pos -= pos % 80;
   pos += 2;
-
-  // update hardware cursor
-  outb(CRTPORT, 14);
-  outb(CRTPORT + 1, pos >> 8);
-  outb(CRTPORT, 15);
-  outb(CRTPORT + 1, pos);
+  cgapos = pos;
 }
\ No newline at end of file
@@ -5,10 +5,19 @@ struct inode;
 struct pipe;
 struct proc;
 struct rtcdate;
+struct rwlock;
 struct spinlock;
 struct sleeplock;
 struct stat;
+struct uartstat;
+struct fsstat;
 struct superblock;
+struct trapframe;
+struct profsample;
+struct lockclass;
+struct lockinfo;
+struct tracerec;
+struct sysstat;
 
 // bio.c
 void            binit(void);
@@ -31,6 +40,7 @@ void            fileclose(struct file*);
 struct file*    filedup(struct file*);
 void            fileinit(void);
 int             fileread(struct file*, char*, int n);
+int             fileseek(struct file*, int, int);
 int             filestat(struct file*, struct stat*);
 int             filewrite(struct file*, char*, int n);
 
@@ -38,9 +48,13 @@ int             filewrite(struct file*, char*, int n);
 void            readsb(int dev, struct superblock *sb);
 int             dirlink(struct inode*, char*, uint);
 struct inode*   dirlookup(struct inode*, char*, uint*);
+void            dirunlink(struct inode*, uint);
+void            fsstat(struct fsstat*);
 struct inode*   ialloc(uint, short);
+void            ichange(struct inode*, int);
 struct inode*   idup(struct inode*);
-void            iinit(int dev);
+void            fsinit(int dev);
+void            iinit(void);
 void            ilock(struct inode*);
 void            iput(struct inode*);
 void            iunlock(struct inode*);
@@ -74,6 +88,7 @@ void            kbdintr(void);
 
 // lapic.c
 void            cmostime(struct rtcdate *r);
+uint            epochtime(void);
 int             lapicid(void);
 extern volatile uint*    lapic;
 void            lapiceoi(void);
@@ -81,6 +96,17 @@ void            lapicinit(void);
 void            lapicstartap(uchar, uint);
 void            microdelay(int);
 
+// lockclass.c
+extern int      lockstat_on;
+struct lockclass* lockclass(char*, int);
+void            lockstat_acquired(struct lockclass*, uint64, int);
+void            lockstat_released(struct lockclass*, uint64);
+void            lockstat_spun(struct lockclass*, int);
+int             lockstat(int, struct lockinfo*, int);
+
+// linediff.c
+int             diff(char*, char*, char*, int);
+
 // log.c
 void            initlog(int dev);
 void            log_write(struct buf*);
@@ -103,6 +129,13 @@ int             pipewrite(struct pipe*, char*, int);
 
 
 //PAGEBREAK: 16
+// prof.c
+void            profinit(void);
+void            proftick(struct trapframe*);
+int             profstart(int);
+void            profstop(void);
+int             profread(struct profsample*, int, uint*);
+
 // proc.c
 int             cpuid(void);
 void            exit(void);
@@ -119,19 +152,19 @@ void            setproc(struct proc*);
 void            sleep(void*, struct spinlock*);
 void            userinit(void);
 int             wait(void);
+int             settrace(int, uint*);
 void            wakeup(void*);
 void            yield(void);
-void            next_palindrome(int);
+int             next_palindrome(char*, char*, int);
 int             set_sleep_syscall(int);
 int             get_system_time(struct rtcdate*);
 
 int             make_user(int, const char*);
 int             login(int, const char*);
 int             logout(void);
+int             setsid(void);
 int             logs(void);
 
-int             diff(const char *file1, const char *file2);
-
 //process scheduling
 int             create_realtime_process(int);
 int             change_process_queue(int pid, int queue);
@@ -151,10 +184,20 @@ void            acquire(struct spinlock*);
 void            getcallerpcs(void*, uint*);
 int             holding(struct spinlock*);
 void            initlock(struct spinlock*, char*);
+void            initticketlock(struct spinlock*, char*);
+int             lockbench(int, uint, uint);
 void            release(struct spinlock*);
 void            pushcli(void);
 void            popcli(void);
 
+// rwlock.c
+void            initrwlock(struct rwlock*, char*, int);
+void            acquireread(struct rwlock*);
+void            releaseread(struct rwlock*);
+void            acquirewrite(struct rwlock*);
+void            releasewrite(struct rwlock*);
+int             rwbench(int, int, uint, uint, int*);
+
 // sleeplock.c
 void            acquiresleep(struct sleeplock*);
 void            releasesleep(struct sleeplock*);
@@ -187,10 +230,26 @@ extern uint     ticks;
 void            tvinit(void);
 extern struct spinlock tickslock;
 
+// trace.c
+void            traceinit(void);
+int             tracewanted(struct proc*, int);
+void            tracebegin(struct tracerec*, int);
+void            traceend(struct tracerec*, uint64, uint64, int);
+int             traceread(struct tracerec*, int, uint*);
+int             auditread(struct tracerec*, int, uint*);
+void            tracedump(int);
+void            setauditmask(uint*);
+void            sysstatadd(int, uint64);
+void            sysstatread(struct sysstat*, int);
+
 // uart.c
 void            uartinit(void);
 void            uartintr(void);
 void            uartputc(int);
+int             uartqueue(char*, int);
+void            uartstart(void);
+void            uartwait(void);
+void            uartstat(struct uartstat*);
 
 // vm.c
 void            seginit(void);
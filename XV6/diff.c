@@ -3,13 +3,34 @@
 
 int main(int argc, char* argv[])
 {
+    char *buf;
+    int n, r;
+
     if (argc != 3) {
-        printf(1, "Usage: diff num\n");
+        printf(2, "usage: diff file1 file2\n");
         exit();
     }
 
-    int result = diff(argv[1], argv[2]);
-
-    printf(1, "result: %d\n", result);
+    // The kernel reports the full length, so one retry with a
+    // buffer that size gets the whole diff.
+    n = 4096;
+    for (;;) {
+        if ((buf = malloc(n)) == 0) {
+            printf(2, "diff: out of memory\n");
+            exit();
+        }
+        if ((r = diff(argv[1], argv[2], buf, n)) <= n)
+            break;
+        free(buf);
+        n = r;
+    }
+    if (r < 0) {
+        printf(2, "diff: cannot compare %s and %s\n", argv[1], argv[2]);
+        exit();
+    }
+    if (r > 0) {
+        printf(1, "--- %s\n+++ %s\n", argv[1], argv[2]);
+        write(1, buf, r);
+    }
     exit();
-}
\ No newline at end of file
+}
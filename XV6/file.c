@@ -9,6 +9,7 @@
 #include "spinlock.h"
 #include "sleeplock.h"
 #include "file.h"
+#include "fcntl.h"
 
 struct devsw devsw[NDEV];
 struct {
@@ -19,7 +20,7 @@ struct {
 void
 fileinit(void)
 {
-  initlock(&ftable.lock, "ftable");
+  initticketlock(&ftable.lock, "ftable");
 }
 
 // Allocate a file structure.
@@ -92,6 +93,25 @@ filestat(struct file *f, struct stat *st)
   return -1;
 }
 
+// Set file f's offset; return the new offset.
+int
+fileseek(struct file *f, int off, int whence)
+{
+  if(f->type != FD_INODE)
+    return -1;
+  ilock(f->ip);
+  if(whence == SEEK_CUR)
+    off += f->off;
+  else if(whence == SEEK_END)
+    off += f->ip->size;
+  else if(whence != SEEK_SET)
+    off = -1;
+  if(off >= 0)
+    f->off = off;
+  iunlock(f->ip);
+  return off < 0 ? -1 : off;
+}
+
 // Read from file f.
 int
 fileread(struct file *f, char *addr, int n)
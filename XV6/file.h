@@ -14,6 +14,9 @@ struct inode {
   uint dev;           // Device number
   uint inum;          // Inode number
   int ref;            // Reference count
+  struct inode *hnext; // icache hash chain
+  struct inode *prev; // icache LRU list of unreferenced inodes
+  struct inode *next;
   struct sleeplock lock; // protects everything below here
   int valid;          // inode has been read from disk?
 
@@ -22,7 +25,11 @@ struct inode {
   short minor;
   short nlink;
   uint size;
+  uint flags;
   uint addrs[NDIRECT+1];
+  uint mtime;
+  uint ctime;
+  uint gen;
 };
 
 // table mapping major device number to
@@ -1,43 +1,193 @@
 #include "types.h"
+#include "stat.h"
 #include "user.h"
 #include "fcntl.h"
 
-int
-main(int argc, char *argv[])
-{
-    if (argc < 2) {
-        printf(1, "Usage: %s <string>\n", argv[0]);
-        exit();
+// find_sum [-j workers] [file ...]
+// find_sum -s string ...
+//
+// Prints the sum of the unsigned decimal numbers in the files (or
+// standard input), or with -s in the arguments themselves.  Input
+// is read in 64KB blocks; a number split between blocks simply
+// carries over.  With -j, each plain file is cut into that many
+// byte ranges, each summed by a child process: a child sums the
+// numbers whose first digit is in its range, reading past the
+// range's end to finish the last one.
+
+#define BUFSIZE  65536
+#define MAXJOBS  8
+
+static char buf[BUFSIZE];
+static uint64 sum, cur;
+
+// Add the numbers in [p, p+n) to sum; cur is the number in progress.
+static void scan(char *p, int n) {
+    uint d;
+
+    for(; n > 0; n--, p++) {
+        d = (uchar)*p - '0';
+        if(d < 10) {
+            cur = cur * 10 + d;
+        } else {
+            // Adds 0 between numbers, which saves a branch.
+            sum += cur;
+            cur = 0;
+        }
     }
+}
 
-    int sum = 0;
-    for(int i = 1 ; i <= argc ; i++){
-        char *str = argv[i];
-        int current = 0;
-        int in_number = 0;
-    
-        for (int i = 0; str[i] != '\0'; i++) {
-            if (str[i] >= '0' && str[i] <= '9') {
-                current = current * 10 + (str[i] - '0');
-                in_number = 1;
-            } else if (in_number) {
-                sum += current;
-                current = 0;
-                in_number = 0;
-            }
+// Sum the numbers starting in [start, end) of fd, or up to the
+// end of the file if end is 0.
+static uint64 sumrange(int fd, uint start, uint end) {
+    int n, i, skip, innum;
+    uint pos, want;
+
+    sum = cur = 0;
+    skip = innum = 0;
+    pos = start;
+    if(start > 0) {
+        // A number running into the range belongs to the range before.
+        if(lseek(fd, start - 1, SEEK_SET) < 0 || read(fd, buf, 1) != 1)
+            return 0;
+        skip = (uint)((uchar)buf[0] - '0') < 10;
+    }
+    for(;;) {
+        want = BUFSIZE;
+        if(end && end - pos < want)
+            want = end - pos;
+        if(want == 0 || (n = read(fd, buf, want)) <= 0)
+            break;
+        pos += n;
+        i = 0;
+        if(skip) {
+            while(i < n && (uint)((uchar)buf[i] - '0') < 10)
+                i++;
+            skip = i == n;
         }
-        if (in_number)
-            sum += current;
+        scan(buf + i, n - i);
+        innum = i < n && (uint)((uchar)buf[n-1] - '0') < 10;
     }
+    // Finish a number that runs past the end.
+    while(end && innum && read(fd, buf, 1) == 1 && (uint)((uchar)buf[0] - '0') < 10)
+        cur = cur * 10 + buf[0] - '0';
+    return sum + cur;
+}
 
-    int fd = open("result.txt", O_CREATE | O_WRONLY);
-    if (fd < 0) {
-        printf(1, "Cannot open result.txt\n");
-        exit();
+// Split name across jobs children; return the sum of their sums.
+static uint64 parallel(char *name, int fd, uint size, int jobs) {
+    int fds[MAXJOBS], p[2], i;
+    uint64 part, total;
+    uint chunk;
+
+    chunk = (size + jobs - 1) / jobs;
+    for(i = 0; i < jobs; i++) {
+        if(pipe(p) < 0) {
+            printf(2, "find_sum: pipe failed\n");
+            exit();
+        }
+        if(fork() == 0) {
+            close(p[0]);
+            close(fd);
+            // Own offset, unshared with the other children.
+            if((fd = open(name, O_RDONLY)) < 0)
+                exit();
+            part = sumrange(fd, i * chunk, i * chunk + chunk < size ? i * chunk + chunk : size);
+            write(p[1], &part, sizeof(part));
+            exit();
+        }
+        close(p[1]);
+        fds[i] = p[0];
+    }
+    total = 0;
+    for(i = 0; i < jobs; i++) {
+        part = 0;
+        if(read(fds[i], &part, sizeof(part)) != sizeof(part))
+            printf(2, "find_sum: worker %d failed on %s\n", i, name);
+        total += part;
+        close(fds[i]);
+        wait();
     }
+    return total;
+}
+
+static uint64 sumfile(char *name, int jobs) {
+    struct stat st;
+    uint64 s;
+    int fd;
 
-    printf(fd, "%d\n", sum);
+    if((fd = open(name, O_RDONLY)) < 0) {
+        printf(2, "find_sum: cannot open %s\n", name);
+        return 0;
+    }
+    if(jobs > 1 && fstat(fd, &st) == 0 && st.type == T_FILE && st.size >= jobs * 4096)
+        s = parallel(name, fd, st.size, jobs);
+    else
+        s = sumrange(fd, 0, 0);
     close(fd);
+    return s;
+}
+
+// x / 10, leaving the remainder, in 32-bit steps: user programs
+// don't have libgcc's 64-bit division.
+static uint div10(uint64 *x) {
+    uint hi, mid, lo, r;
+
+    hi = *x >> 32;
+    r = hi % 10;
+    hi /= 10;
+    mid = (r << 16) | (uint)(*x >> 16 & 0xffff);
+    r = mid % 10;
+    mid /= 10;
+    lo = (r << 16) | (uint)(*x & 0xffff);
+    r = lo % 10;
+    lo /= 10;
+    *x = ((uint64)hi << 32) | (mid << 16) | lo;
+    return r;
+}
+
+static void print64(uint64 x) {
+    char s[24];
+    int i;
+
+    i = sizeof(s) - 1;
+    s[i] = 0;
+    do {
+        s[--i] = '0' + div10(&x);
+    } while(x != 0);
+    printf(1, "%s\n", s + i);
+}
+
+int main(int argc, char *argv[]) {
+    uint64 total;
+    int i, jobs;
+
+    jobs = 1;
+    total = 0;
+    i = 1;
+    if(argc > 1 && strcmp(argv[1], "-s") == 0) {
+        for(i = 2; i < argc; i++) {
+            scan(argv[i], strlen(argv[i]));
+            sum += cur;
+            cur = 0;
+        }
+        print64(sum);
+        exit();
+    }
+    if(argc > 2 && strcmp(argv[1], "-j") == 0) {
+        jobs = atoi(argv[2]);
+        i = 3;
+    }
+    if(jobs < 1 || (i < argc && argv[i][0] == '-' && argv[i][1])) {
+        printf(2, "usage: find_sum [-j workers] [file ...] | find_sum -s string ...\n");
+        exit();
+    }
+    if(jobs > MAXJOBS)
+        jobs = MAXJOBS;
 
+    if(i == argc)
+        total = sumrange(0, 0, 0);
+    for(; i < argc; i++)
+        total += sumfile(argv[i], jobs);
+    print64(total);
     exit();
 }
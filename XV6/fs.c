@@ -23,6 +23,8 @@
 
 #define min(a, b) ((a) < (b) ? (a) : (b))
 static void itrunc(struct inode*);
+static void dcacheinit(void);
+static int dcachelast(struct inode*);
 // there should be one superblock per disk device, but we run with
 // only one device
 struct superblock sb; 
@@ -154,30 +156,69 @@ bfree(int dev, uint b)
 // have locked the inodes involved; this lets callers create
 // multi-step atomic operations.
 //
-// The icache.lock spin-lock protects the allocation of icache
-// entries. Since ip->ref indicates whether an entry is free,
-// and ip->dev and ip->inum indicate which i-node an entry
-// holds, one must hold icache.lock while using any of those fields.
+// The inode cache is a hash table of NIHASH chains indexed by
+// (dev, inum).  Each chain's spin-lock protects ip->ref, ip->dev,
+// ip->inum and ip->hnext of the entries on it, so lookups of
+// different inodes do not contend.  Entries whose ref has fallen
+// to zero stay on their chain, still valid, and are also kept on
+// an LRU list (protected by icache.lrulock) from which iget()
+// recycles the least recently used one when it needs a new entry.
+// icache.lock serializes recycling, which is the only thing that
+// moves an entry between chains.  Lock order: icache.lock, then
+// chain locks, then icache.lrulock.
 //
 // An ip->lock sleep-lock protects all ip-> fields other than ref,
 // dev, and inum.  One must hold ip->lock in order to
 // read or write that inode's ip->valid, ip->size, ip->type, &c.
 
+#define NIHASH 61
+
+struct ibucket {
+  struct spinlock lock;
+  struct inode *head;
+  uint hits;
+};
+
 struct {
   struct spinlock lock;
+  struct spinlock lrulock;
   struct inode inode[NINODE];
+  struct ibucket bucket[NIHASH];
+
+  // Unreferenced entries, through prev/next.
+  // lru.next is most recently used.
+  struct inode lru;
+  uint misses;
 } icache;
 
+// Set up the in-memory inode and dentry caches.
 void
-iinit(int dev)
+iinit(void)
 {
-  int i = 0;
-  
-  initlock(&icache.lock, "icache");
-  for(i = 0; i < NINODE; i++) {
-    initsleeplock(&icache.inode[i].lock, "inode");
+  struct inode *ip;
+  int i;
+
+  initticketlock(&icache.lock, "icache");
+  initlock(&icache.lrulock, "icache.lru");
+  for(i = 0; i < NIHASH; i++)
+    initlock(&icache.bucket[i].lock, "icache.bucket");
+  icache.lru.prev = &icache.lru;
+  icache.lru.next = &icache.lru;
+  for(ip = icache.inode; ip < icache.inode+NINODE; ip++){
+    initsleeplock(&ip->lock, "inode");
+    ip->next = icache.lru.next;
+    ip->prev = &icache.lru;
+    icache.lru.next->prev = ip;
+    icache.lru.next = ip;
   }
+  dcacheinit();
+}
 
+// Read the super block of dev.  Must run in a process
+// context since it sleeps on the disk.
+void
+fsinit(int dev)
+{
   readsb(dev, &sb);
   cprintf("sb: size %d nblocks %d ninodes %d nlog %d logstart %d\
  inodestart %d bmap start %d\n", sb.size, sb.nblocks,
@@ -197,13 +238,19 @@ ialloc(uint dev, short type)
   int inum;
   struct buf *bp;
   struct dinode *dip;
+  uint gen;
 
   for(inum = 1; inum < sb.ninodes; inum++){
     bp = bread(dev, IBLOCK(inum, sb));
     dip = (struct dinode*)bp->data + inum%IPB;
     if(dip->type == 0){  // a free inode
+      // Keep gen growing, so that a new file never matches
+      // a stale (ino, gen) of the one this inode held before.
+      gen = dip->gen + 1;
       memset(dip, 0, sizeof(*dip));
       dip->type = type;
+      dip->mtime = dip->ctime = epochtime();
+      dip->gen = gen;
       log_write(bp);   // mark it allocated on the disk
       brelse(bp);
       return iget(dev, inum);
@@ -230,42 +277,138 @@ iupdate(struct inode *ip)
   dip->minor = ip->minor;
   dip->nlink = ip->nlink;
   dip->size = ip->size;
+  dip->flags = ip->flags;
   memmove(dip->addrs, ip->addrs, sizeof(ip->addrs));
+  dip->mtime = ip->mtime;
+  dip->ctime = ip->ctime;
+  dip->gen = ip->gen;
   log_write(bp);
   brelse(bp);
 }
 
+// Stamp a change to ip: to its contents if data is set, else
+// only to the inode itself.  The caller must then iupdate(ip).
+// Caller must hold ip->lock.
+void
+ichange(struct inode *ip, int data)
+{
+  ip->ctime = epochtime();
+  if(data){
+    ip->mtime = ip->ctime;
+    ip->gen++;
+  }
+}
+
+static struct ibucket*
+ibucket(uint dev, uint inum)
+{
+  return &icache.bucket[(dev*131 + inum) % NIHASH];
+}
+
+// Take ip off the LRU list.
+static void
+lruremove(struct inode *ip)
+{
+  acquire(&icache.lrulock);
+  ip->next->prev = ip->prev;
+  ip->prev->next = ip->next;
+  release(&icache.lrulock);
+}
+
+// Put an unreferenced ip on the LRU list: at the front if
+// it holds a valid inode worth keeping, else at the back so
+// that it is recycled first.
+static void
+lruinsert(struct inode *ip)
+{
+  struct inode *after;
+
+  acquire(&icache.lrulock);
+  after = ip->valid ? &icache.lru : icache.lru.prev;
+  ip->next = after->next;
+  ip->prev = after;
+  after->next->prev = ip;
+  after->next = ip;
+  release(&icache.lrulock);
+}
+
+// Look for (dev, inum) on chain b and take a reference to it.
+// Caller must hold b->lock.
+static struct inode*
+ifind(struct ibucket *b, uint dev, uint inum)
+{
+  struct inode *ip;
+
+  for(ip = b->head; ip; ip = ip->hnext){
+    if(ip->dev == dev && ip->inum == inum){
+      if(ip->ref++ == 0)
+        lruremove(ip);
+      b->hits++;
+      return ip;
+    }
+  }
+  return 0;
+}
+
 // Find the inode with number inum on device dev
 // and return the in-memory copy. Does not lock
 // the inode and does not read it from disk.
 static struct inode*
 iget(uint dev, uint inum)
 {
-  struct inode *ip, *empty;
-
-  acquire(&icache.lock);
+  struct ibucket *b, *ob;
+  struct inode *ip, **pp;
 
   // Is the inode already cached?
-  empty = 0;
-  for(ip = &icache.inode[0]; ip < &icache.inode[NINODE]; ip++){
-    if(ip->ref > 0 && ip->dev == dev && ip->inum == inum){
-      ip->ref++;
-      release(&icache.lock);
-      return ip;
-    }
-    if(empty == 0 && ip->ref == 0)    // Remember empty slot.
-      empty = ip;
+  b = ibucket(dev, inum);
+  acquire(&b->lock);
+  if((ip = ifind(b, dev, inum)) != 0){
+    release(&b->lock);
+    return ip;
   }
+  release(&b->lock);
 
-  // Recycle an inode cache entry.
-  if(empty == 0)
-    panic("iget: no inodes");
+  // Not cached; recycle the least recently used free entry.
+  acquire(&icache.lock);
+  acquire(&b->lock);
+  if((ip = ifind(b, dev, inum)) != 0){  // another iget got here first
+    release(&b->lock);
+    release(&icache.lock);
+    return ip;
+  }
+  for(;;){
+    acquire(&icache.lrulock);
+    ip = icache.lru.prev;
+    release(&icache.lrulock);
+    if(ip == &icache.lru)
+      panic("iget: no inodes");
+    // Only the holder of icache.lock changes ip->dev and ip->inum,
+    // but ifind() may still take a reference until we lock ip's chain.
+    ob = ip->dev ? ibucket(ip->dev, ip->inum) : 0;
+    if(ob && ob != b)
+      acquire(&ob->lock);
+    if(ip->ref == 0)
+      break;
+    if(ob && ob != b)
+      release(&ob->lock);
+  }
+  if(ob){
+    for(pp = &ob->head; *pp != ip; pp = &(*pp)->hnext)
+      ;
+    *pp = ip->hnext;
+    if(ob != b)
+      release(&ob->lock);
+  }
+  lruremove(ip);
 
-  ip = empty;
   ip->dev = dev;
   ip->inum = inum;
   ip->ref = 1;
   ip->valid = 0;
+  ip->hnext = b->head;
+  b->head = ip;
+  icache.misses++;
+  release(&b->lock);
   release(&icache.lock);
 
   return ip;
@@ -276,9 +419,12 @@ iget(uint dev, uint inum)
 struct inode*
 idup(struct inode *ip)
 {
-  acquire(&icache.lock);
+  struct ibucket *b;
+
+  b = ibucket(ip->dev, ip->inum);
+  acquire(&b->lock);
   ip->ref++;
-  release(&icache.lock);
+  release(&b->lock);
   return ip;
 }
 
@@ -303,7 +449,11 @@ ilock(struct inode *ip)
     ip->minor = dip->minor;
     ip->nlink = dip->nlink;
     ip->size = dip->size;
+    ip->flags = dip->flags;
     memmove(ip->addrs, dip->addrs, sizeof(ip->addrs));
+    ip->mtime = dip->mtime;
+    ip->ctime = dip->ctime;
+    ip->gen = dip->gen;
     brelse(bp);
     ip->valid = 1;
     if(ip->type == 0)
@@ -331,12 +481,12 @@ iunlock(struct inode *ip)
 void
 iput(struct inode *ip)
 {
+  struct ibucket *b;
+
+  b = ibucket(ip->dev, ip->inum);
   acquiresleep(&ip->lock);
   if(ip->valid && ip->nlink == 0){
-    acquire(&icache.lock);
-    int r = ip->ref;
-    release(&icache.lock);
-    if(r == 1){
+    if(dcachelast(ip)){
       // inode has no links and no other references: truncate and free.
       itrunc(ip);
       ip->type = 0;
@@ -346,9 +496,10 @@ iput(struct inode *ip)
   }
   releasesleep(&ip->lock);
 
-  acquire(&icache.lock);
-  ip->ref--;
-  release(&icache.lock);
+  acquire(&b->lock);
+  if(--ip->ref == 0)
+    lruinsert(ip);
+  release(&b->lock);
 }
 
 // Common idiom: unlock, then put.
@@ -431,6 +582,7 @@ itrunc(struct inode *ip)
   }
 
   ip->size = 0;
+  ichange(ip, 1);
   iupdate(ip);
 }
 
@@ -444,6 +596,9 @@ stati(struct inode *ip, struct stat *st)
   st->type = ip->type;
   st->nlink = ip->nlink;
   st->size = ip->size;
+  st->mtime = ip->mtime;
+  st->ctime = ip->ctime;
+  st->gen = ip->gen;
 }
 
 //PAGEBREAK!
@@ -503,8 +658,10 @@ writei(struct inode *ip, char *src, uint off, uint n)
     brelse(bp);
   }
 
-  if(n > 0 && off > ip->size){
-    ip->size = off;
+  if(n > 0){
+    if(off > ip->size)
+      ip->size = off;
+    ichange(ip, 1);
     iupdate(ip);
   }
   return n;
@@ -519,32 +676,311 @@ namecmp(const char *s, const char *t)
   return strncmp(s, t, DIRSIZ);
 }
 
+// Hash of a directory entry name, for hashed directories.
+// mkfs.c computes the same function when it builds the root.
+static uint
+dirhash(char *name)
+{
+  uint h;
+  int i;
+
+  h = 2166136261;  // FNV-1a
+  for(i = 0; i < DIRSIZ && name[i]; i++){
+    h ^= (uchar)name[i];
+    h *= 16777619;
+  }
+  return h;
+}
+
+// Directory entry cache.
+//
+// The dcache remembers recent name lookups, keyed by
+// (dev, directory inum, name), so that namex() can walk a
+// path it has seen before without locking the directories
+// on the way or reading their blocks.  An entry with inum 0
+// is negative: the name is known not to exist.
+//
+// Entries are only added or changed while the directory they
+// describe is locked (namex, dirlink, dirunlink), so an entry
+// never disagrees with the directory's contents.  iput() drops
+// every entry mentioning an inode that it frees, before the
+// inode number can be reused.  A lookup takes its reference to
+// the named inode before it lets go of dcache.lock, and iput()
+// checks for the last reference under the same lock, so a
+// lookup never hands out an inode that is being freed.
+//
+// The dcache.lock spin-lock protects all of the fields below.
+
+#define NDHASH 64
+
+struct dentry {
+  uint dev;
+  uint dir;              // inum of the containing directory
+  uint inum;             // inum of the named inode, 0 if absent
+  char name[DIRSIZ];
+  struct dentry *hnext;  // hash chain
+  struct dentry *prev;   // LRU list
+  struct dentry *next;
+};
+
+struct {
+  struct spinlock lock;
+  struct dentry dentry[NDENTRY];
+  struct dentry *hash[NDHASH];
+
+  // Linked list of all entries, through prev/next.
+  // head.next is most recently used.
+  struct dentry head;
+
+  uint hits;
+  uint neghits;
+  uint misses;
+} dcache;
+
+static void
+dcacheinit(void)
+{
+  struct dentry *d;
+
+  initticketlock(&dcache.lock, "dcache");
+  dcache.head.prev = &dcache.head;
+  dcache.head.next = &dcache.head;
+  for(d = dcache.dentry; d < dcache.dentry+NDENTRY; d++){
+    d->next = dcache.head.next;
+    d->prev = &dcache.head;
+    dcache.head.next->prev = d;
+    dcache.head.next = d;
+  }
+}
+
+static struct dentry**
+dbucket(uint dev, uint dir, char *name)
+{
+  return &dcache.hash[(dirhash(name) ^ (dir * 31) ^ dev) % NDHASH];
+}
+
+// Find the entry for (dev, dir, name).
+// Caller must hold dcache.lock.
+static struct dentry*
+dfind(uint dev, uint dir, char *name)
+{
+  struct dentry *d;
+
+  for(d = *dbucket(dev, dir, name); d; d = d->hnext)
+    if(d->dev == dev && d->dir == dir && namecmp(d->name, name) == 0)
+      return d;
+  return 0;
+}
+
+// Take d off its hash chain and mark it unused.
+// Caller must hold dcache.lock.
+static void
+dunhash(struct dentry *d)
+{
+  struct dentry **pp;
+
+  if(d->dev == 0)
+    return;
+  for(pp = dbucket(d->dev, d->dir, d->name); *pp; pp = &(*pp)->hnext){
+    if(*pp == d){
+      *pp = d->hnext;
+      break;
+    }
+  }
+  d->dev = 0;
+  d->hnext = 0;
+}
+
+// Move d to the head of the MRU list.
+// Caller must hold dcache.lock.
+static void
+dtouch(struct dentry *d)
+{
+  d->next->prev = d->prev;
+  d->prev->next = d->next;
+  d->next = dcache.head.next;
+  d->prev = &dcache.head;
+  dcache.head.next->prev = d;
+  dcache.head.next = d;
+}
+
+// Record that name in directory dir maps to inum
+// (or, if inum is 0, that it does not exist).
+// Caller must hold the directory's inode lock.
+static void
+dcacheenter(uint dev, uint dir, char *name, uint inum)
+{
+  struct dentry *d;
+
+  acquire(&dcache.lock);
+  if((d = dfind(dev, dir, name)) == 0){
+    // Recycle the least recently used entry.
+    d = dcache.head.prev;
+    dunhash(d);
+    d->dev = dev;
+    d->dir = dir;
+    strncpy(d->name, name, DIRSIZ);
+    d->hnext = *dbucket(dev, dir, name);
+    *dbucket(dev, dir, name) = d;
+  }
+  d->inum = inum;
+  dtouch(d);
+  release(&dcache.lock);
+}
+
+// Look name up in the cache for directory dp.
+// Return 1 on a hit, with *pip set to a new reference to the
+// named inode (0 for a negative entry), and 0 on a miss.
+static int
+dcachelookup(struct inode *dp, char *name, struct inode **pip)
+{
+  struct dentry *d;
+
+  acquire(&dcache.lock);
+  if((d = dfind(dp->dev, dp->inum, name)) == 0){
+    dcache.misses++;
+    release(&dcache.lock);
+    return 0;
+  }
+  *pip = d->inum ? iget(dp->dev, d->inum) : 0;
+  dcache.hits++;
+  if(d->inum == 0)
+    dcache.neghits++;
+  dtouch(d);
+  release(&dcache.lock);
+  return 1;
+}
+
+// If the caller holds the only reference to ip, drop every
+// entry that is in, or names, ip and return 1; else return 0.
+// Called by iput() on an inode with no links.
+static int
+dcachelast(struct inode *ip)
+{
+  struct ibucket *b;
+  struct dentry *d;
+  int last;
+
+  b = ibucket(ip->dev, ip->inum);
+  acquire(&dcache.lock);
+  acquire(&b->lock);
+  last = ip->ref == 1;
+  release(&b->lock);
+  if(last)
+    for(d = dcache.dentry; d < dcache.dentry+NDENTRY; d++)
+      if(d->dev == ip->dev && (d->dir == ip->inum || d->inum == ip->inum))
+        dunhash(d);
+  release(&dcache.lock);
+  return last;
+}
+
+// Copy the cache statistics out for fsstat().
+void
+fsstat(struct fsstat *st)
+{
+  int i;
+
+  acquire(&dcache.lock);
+  st->dcache_hits = dcache.hits;
+  st->dcache_neghits = dcache.neghits;
+  st->dcache_misses = dcache.misses;
+  release(&dcache.lock);
+
+  st->icache_hits = 0;
+  for(i = 0; i < NIHASH; i++)
+    st->icache_hits += icache.bucket[i].hits;
+  st->icache_misses = icache.misses;
+}
+
+// Scan the entries of dp from byte offset off to the end,
+// one block at a time, for name.
+// Return its inode number and set *poff, or return 0.
+static uint
+dirscan(struct inode *dp, char *name, uint off, uint *poff)
+{
+  uint inum, n;
+  struct buf *bp;
+  struct dirent *de;
+
+  for(; off < dp->size; off += n){
+    n = min(dp->size - off, BSIZE - off%BSIZE);
+    bp = bread(dp->dev, bmap(dp, off/BSIZE));
+    for(de = (struct dirent*)(bp->data + off%BSIZE);
+        de < (struct dirent*)(bp->data + off%BSIZE + n); de++){
+      if(de->inum != 0 && namecmp(name, de->name) == 0){
+        inum = de->inum;
+        *poff = off/BSIZE*BSIZE + (uchar*)de - bp->data;
+        brelse(bp);
+        return inum;
+      }
+    }
+    brelse(bp);
+  }
+  return 0;
+}
+
+// Probe the hash table of a hashed directory for name.
+// If want is zero, look for a live entry called name;
+// otherwise look for a free slot to hold it.
+// Return 1 and set *poff (and *pinum) on success, 0 if the probe
+// ended at a never-used slot, and -1 if the whole table was searched.
+static int
+dirprobe(struct inode *dp, char *name, int want, uint *poff, uint *pinum)
+{
+  uint i, b;
+  int open;
+  struct buf *bp;
+  struct dirent *de;
+
+  b = dirhash(name) % DIRHASH_NBUCKET;
+  for(i = 0; i < DIRHASH_NBUCKET; i++, b = (b + 1) % DIRHASH_NBUCKET){
+    bp = bread(dp->dev, bmap(dp, b));
+    open = 0;
+    for(de = (struct dirent*)bp->data; de < (struct dirent*)bp->data + DPB; de++){
+      if(de->inum == 0 && de->name[0] == 0)
+        open = 1;
+      if(want ? de->inum == 0 : (de->inum != 0 && namecmp(name, de->name) == 0)){
+        *poff = b*BSIZE + (uchar*)de - bp->data;
+        *pinum = de->inum;
+        brelse(bp);
+        return 1;
+      }
+    }
+    brelse(bp);
+    if(open)
+      return 0;
+  }
+  return -1;
+}
+
 // Look for a directory entry in a directory.
 // If found, set *poff to byte offset of entry.
 struct inode*
 dirlookup(struct inode *dp, char *name, uint *poff)
 {
   uint off, inum;
-  struct dirent de;
 
   if(dp->type != T_DIR)
     panic("dirlookup not DIR");
 
-  for(off = 0; off < dp->size; off += sizeof(de)){
-    if(readi(dp, (char*)&de, off, sizeof(de)) != sizeof(de))
-      panic("dirlookup read");
-    if(de.inum == 0)
-      continue;
-    if(namecmp(name, de.name) == 0){
-      // entry matches path element
-      if(poff)
-        *poff = off;
-      inum = de.inum;
-      return iget(dp->dev, inum);
+  if(dp->flags & I_HASHDIR){
+    switch(dirprobe(dp, name, 0, &off, &inum)){
+    case 1:
+      break;
+    case 0:
+      return 0;
+    default:
+      // Table is full; the name may be in the overflow area.
+      if((inum = dirscan(dp, name, DIRHASH_NBUCKET*BSIZE, &off)) == 0)
+        return 0;
+      break;
     }
-  }
+  } else if((inum = dirscan(dp, name, 0, &off)) == 0)
+    return 0;
 
-  return 0;
+  if(poff)
+    *poff = off;
+  return iget(dp->dev, inum);
 }
 
 // Write a new directory entry (name, inum) into the directory dp.
@@ -552,6 +988,7 @@ int
 dirlink(struct inode *dp, char *name, uint inum)
 {
   int off;
+  uint hoff, hinum;
   struct dirent de;
   struct inode *ip;
 
@@ -561,22 +998,47 @@ dirlink(struct inode *dp, char *name, uint inum)
     return -1;
   }
 
-  // Look for an empty dirent.
-  for(off = 0; off < dp->size; off += sizeof(de)){
-    if(readi(dp, (char*)&de, off, sizeof(de)) != sizeof(de))
-      panic("dirlink read");
-    if(de.inum == 0)
-      break;
+  if((dp->flags & I_HASHDIR) && dirprobe(dp, name, 1, &hoff, &hinum) == 1){
+    off = hoff;
+  } else {
+    // Look for an empty dirent past the hash table, if any.
+    off = (dp->flags & I_HASHDIR) ? DIRHASH_NBUCKET*BSIZE : 0;
+    for(; off < dp->size; off += sizeof(de)){
+      if(readi(dp, (char*)&de, off, sizeof(de)) != sizeof(de))
+        panic("dirlink read");
+      if(de.inum == 0)
+        break;
+    }
   }
 
+  memset(&de, 0, sizeof(de));
   strncpy(de.name, name, DIRSIZ);
   de.inum = inum;
   if(writei(dp, (char*)&de, off, sizeof(de)) != sizeof(de))
     panic("dirlink");
+  dcacheenter(dp->dev, dp->inum, de.name, inum);
 
   return 0;
 }
 
+// Remove the directory entry at byte offset off in dp.
+// Entries in the hash table of a hashed directory keep
+// their name so that later probes step over them.
+void
+dirunlink(struct inode *dp, uint off)
+{
+  struct dirent de;
+
+  if(readi(dp, (char*)&de, off, sizeof(de)) != sizeof(de))
+    panic("dirunlink read");
+  dcacheenter(dp->dev, dp->inum, de.name, 0);
+  if(!(dp->flags & I_HASHDIR) || off >= DIRHASH_NBUCKET*BSIZE)
+    memset(&de, 0, sizeof(de));
+  de.inum = 0;
+  if(writei(dp, (char*)&de, off, sizeof(de)) != sizeof(de))
+    panic("dirunlink");
+}
+
 //PAGEBREAK!
 // Paths
 
@@ -632,6 +1094,15 @@ namex(char *path, int nameiparent, char *name)
     ip = idup(myproc()->cwd);
 
   while((path = skipelem(path, name)) != 0){
+    if(!(nameiparent && *path == '\0') &&
+       dcachelookup(ip, name, &next)){
+      // Only directories have entries, so ip needs no check.
+      iput(ip);
+      if(next == 0)
+        return 0;
+      ip = next;
+      continue;
+    }
     ilock(ip);
     if(ip->type != T_DIR){
       iunlockput(ip);
@@ -643,9 +1114,11 @@ namex(char *path, int nameiparent, char *name)
       return ip;
     }
     if((next = dirlookup(ip, name, 0)) == 0){
+      dcacheenter(ip->dev, ip->inum, name, 0);
       iunlockput(ip);
       return 0;
     }
+    dcacheenter(ip->dev, ip->inum, name, next->inum);
     iunlockput(ip);
     ip = next;
   }
@@ -25,6 +25,9 @@ struct superblock {
 #define NINDIRECT (BSIZE / sizeof(uint))
 #define MAXFILE (NDIRECT + NINDIRECT)
 
+// Inode flags (dinode.flags)
+#define I_HASHDIR 0x1  // directory is a hashed index (see DIRHASH_NBUCKET)
+
 // On-disk inode structure
 struct dinode {
   short type;           // File type
@@ -32,7 +35,12 @@ struct dinode {
   short minor;          // Minor device number (T_DEV only)
   short nlink;          // Number of links to inode in file system
   uint size;            // Size of file (bytes)
+  uint flags;           // I_* flags
   uint addrs[NDIRECT+1];   // Data block addresses
+  uint mtime;           // Last change to the contents (epochtime)
+  uint ctime;           // Last change to the inode
+  uint gen;             // Contents changes, over all uses of the inode
+  uint pad[12];         // Keep BSIZE a multiple of sizeof(struct dinode)
 };
 
 // Inodes per block.
@@ -55,3 +63,15 @@ struct dirent {
   char name[DIRSIZ];
 };
 
+// Directory entries per block.
+#define DPB           (BSIZE / sizeof(struct dirent))
+
+// A hashed directory (I_HASHDIR) uses its first DIRHASH_NBUCKET blocks
+// as an open-addressed hash table: the entry for name lives in block
+// dirhash(name) % DIRHASH_NBUCKET, or in a following block when that
+// one is full.  Removed entries keep their name with inum 0 so probing
+// continues past them; a never-used slot (inum 0, empty name) ends the
+// probe.  Entries that do not fit in the table are appended linearly
+// after it, so a full table degrades to a plain directory.
+#define DIRHASH_NBUCKET 16
+
@@ -0,0 +1,27 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+int main(int argc, char* argv[]) {
+    struct fsstat st;
+    uint lookups;
+
+    if(fsstat(&st) < 0) {
+        printf(2, "fsstat: failed\n");
+        exit();
+    }
+
+    lookups = st.dcache_hits + st.dcache_misses;
+    printf(1, "dcache: %d lookups, %d hits (%d negative), %d misses\n",
+           lookups, st.dcache_hits, st.dcache_neghits, st.dcache_misses);
+    if(lookups > 0)
+        printf(1, "dcache hit rate: %d%%\n", st.dcache_hits * 100 / lookups);
+
+    lookups = st.icache_hits + st.icache_misses;
+    printf(1, "icache: %d lookups, %d hits, %d misses\n",
+           lookups, st.icache_hits, st.icache_misses);
+    if(lookups > 0)
+        printf(1, "icache hit rate: %d%%\n", st.icache_hits * 100 / lookups);
+
+    exit();
+}
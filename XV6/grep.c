@@ -1,107 +1,693 @@
-// Simple grep.  Only supports ^ . * $ operators.
+// grep [-cnv] [-j jobs] pattern [file ...]
+//
+// Patterns support literals, \c escapes, . [class] [^class]
+// ( ) | * + ? ^ and $.  A pattern is compiled to an NFA
+// (Thompson's construction) and lines are run through a DFA
+// whose states, sets of NFA states, are built on demand as
+// lines need them and cached.  When the pattern must start with
+// a literal string, lines without it are skipped by searching
+// the buffer with Boyer-Moore-Horspool.
+//
+// With -j, files are searched by up to that many child
+// processes at once, their output passed back through pipes in
+// file order.
 
 #include "types.h"
 #include "stat.h"
 #include "user.h"
+#include "fcntl.h"
 
-char buf[1024];
-int match(char*, char*);
+#define BUFSIZE   65536
+#define NDSTATE   128         // Cached DFA states
+#define NHASH     256
+#define MAXJOBS   8
 
-void
-grep(char *pattern, int fd)
+// NFA state ops.
+#define NCHAR     1           // Consume a byte in sets[set]
+#define NSPLIT    2           // Go to out and out1
+#define NNOP      3           // Go to out
+#define NBOL      4           // Go to out at the start of a line
+#define NEOL      5           // Go to out at the end of a line
+#define NMATCH    6
+
+struct nstate {
+  int op;
+  int set;
+  int out, out1;
+};
+
+// A fragment of NFA under construction: start state and its
+// single NNOP exit, whose out is set when it is joined.
+struct frag {
+  int start, end;
+};
+
+// A DFA state: the sorted NFA states it stands for, and its
+// transitions so far (-1 if not yet built).
+struct dstate {
+  int *nfa;
+  int n;
+  int accept;                 // Contains NMATCH: the line matches
+  int acceptend;              // Matches if the line ends here
+  int dead;                   // No match possible on this line
+  int hnext;
+  short next[256];
+};
+
+static struct nstate *nfa;
+static int nnfa, nfastart;
+static uchar (*sets)[32];
+static int nsets;
+static char *re;              // Parser position
+
+static struct dstate *dfa;
+static int ndfa, dinit, nflush;
+static int hashtab[NHASH];
+static int *pool, npool;      // Space for dstate.nfa lists
+static int *mark, gen;
+static int *list, nlist, *stk;
+
+static char lit[256];         // Required literal prefix
+static int nlit, skip[256];
+
+static int cflag, nflag, vflag, multi;
+static char *buf;
+static int bufsize;
+
+static void
+fail(char *msg)
 {
-  int n, m;
-  char *p, *q;
+  printf(2, "grep: %s\n", msg);
+  exit();
+}
 
-  m = 0;
-  while((n = read(fd, buf+m, sizeof(buf)-m-1)) > 0){
-    m += n;
-    buf[m] = '\0';
-    p = buf;
-    while((q = strchr(p, '\n')) != 0){
-      *q = 0;
-      if(match(pattern, p)){
-        *q = '\n';
-        write(1, p, q+1 - p);
-      }
-      p = q+1;
-    }
-    if(p == buf)
-      m = 0;
-    if(m > 0){
-      m -= p - buf;
-      memmove(buf, p, m);
+static int
+newstate(int op, int out)
+{
+  nfa[nnfa].op = op;
+  nfa[nnfa].set = -1;
+  nfa[nnfa].out = out;
+  nfa[nnfa].out1 = -1;
+  return nnfa++;
+}
+
+static struct frag
+frag(int start, int end)
+{
+  struct frag f;
+
+  f.start = start;
+  f.end = end;
+  return f;
+}
+
+// A fragment consuming one byte of a new, empty set.
+static struct frag
+byte(void)
+{
+  int e, s;
+
+  e = newstate(NNOP, -1);
+  s = newstate(NCHAR, e);
+  nfa[s].set = nsets;
+  memset(sets[nsets++], 0, 32);
+  return frag(s, e);
+}
+
+static void
+setbit(int set, int c)
+{
+  sets[set][c >> 3] |= 1 << (c & 7);
+}
+
+static int
+hasbit(int set, int c)
+{
+  return sets[set][c >> 3] & (1 << (c & 7));
+}
+
+static struct frag alt(void);
+
+static struct frag
+class(void)
+{
+  struct frag f;
+  int set, neg, c, d, i;
+
+  f = byte();
+  set = nfa[f.start].set;
+  neg = 0;
+  if(*re == '^'){
+    neg = 1;
+    re++;
+  }
+  // A ] first is a member.
+  do {
+    if(*re == 0)
+      fail("unmatched [");
+    c = (uchar)*re++;
+    if(c == '\\' && *re)
+      c = (uchar)*re++;
+    d = c;
+    if(re[0] == '-' && re[1] && re[1] != ']'){
+      d = (uchar)re[1];
+      re += 2;
+      if(d == '\\' && *re)
+        d = (uchar)*re++;
     }
+    for(; c <= d; c++)
+      setbit(set, c);
+  } while(*re != ']');
+  re++;
+  if(neg){
+    for(i = 0; i < 32; i++)
+      sets[set][i] ^= 0xff;
+    sets[set]['\n' >> 3] &= ~(1 << ('\n' & 7));
   }
+  return f;
 }
 
-int
-main(int argc, char *argv[])
+static struct frag
+atom(void)
 {
-  int fd, i;
-  char *pattern;
+  struct frag f;
+  int c, i, e;
 
-  if(argc <= 1){
-    printf(2, "usage: grep pattern [file ...]\n");
-    exit();
+  c = (uchar)*re++;
+  switch(c){
+  case '(':
+    f = alt();
+    if(*re++ != ')')
+      fail("unmatched (");
+    return f;
+  case '[':
+    return class();
+  case '.':
+    f = byte();
+    for(i = 0; i < 32; i++)
+      sets[nfa[f.start].set][i] = 0xff;
+    sets[nfa[f.start].set]['\n' >> 3] &= ~(1 << ('\n' & 7));
+    return f;
+  case '^':
+  case '$':
+    e = newstate(NNOP, -1);
+    return frag(newstate(c == '^' ? NBOL : NEOL, e), e);
+  case '\\':
+    if(*re)
+      c = (uchar)*re++;
+    break;
   }
-  pattern = argv[1];
+  f = byte();
+  setbit(nfa[f.start].set, c);
+  return f;
+}
 
-  if(argc <= 2){
-    grep(pattern, 0);
-    exit();
+static struct frag
+repeat(void)
+{
+  struct frag f;
+  int s, e;
+
+  f = atom();
+  while(*re == '*' || *re == '+' || *re == '?'){
+    e = newstate(NNOP, -1);
+    s = newstate(NSPLIT, f.start);
+    nfa[s].out1 = e;
+    if(*re == '?')
+      nfa[f.end].out = e;
+    else
+      nfa[f.end].out = s;
+    f = frag(*re == '+' ? f.start : s, e);
+    re++;
+  }
+  return f;
+}
+
+static struct frag
+cat(void)
+{
+  struct frag f, g;
+
+  f.start = f.end = newstate(NNOP, -1);
+  while(*re && *re != '|' && *re != ')'){
+    g = repeat();
+    nfa[f.end].out = g.start;
+    f.end = g.end;
+  }
+  return f;
+}
+
+static struct frag
+alt(void)
+{
+  struct frag f, g;
+  int s, e;
+
+  f = cat();
+  while(*re == '|'){
+    re++;
+    g = cat();
+    e = newstate(NNOP, -1);
+    s = newstate(NSPLIT, f.start);
+    nfa[s].out1 = g.start;
+    nfa[f.end].out = e;
+    nfa[g.end].out = e;
+    f = frag(s, e);
+  }
+  return f;
+}
+
+// The literal string every match must start with, if any.
+static void
+prefix(char *p)
+{
+  char *q;
+  int depth;
+
+  depth = 0;
+  for(q = p; *q; q++){
+    if(*q == '\\' && q[1])
+      q++;
+    else if(*q == '[')
+      while(q[1] && *++q != ']')
+        ;
+    else if(*q == '(')
+      depth++;
+    else if(*q == ')')
+      depth--;
+    else if(*q == '|' && depth == 0)
+      return;
   }
+  while(*p && nlit < sizeof(lit)){
+    if(*p == '\\' && p[1])
+      p++;
+    else if(strchr(".[]()|*+?^$", *p))
+      break;
+    lit[nlit++] = *p++;
+  }
+  // An optional last character isn't required.
+  if(nlit > 0 && (*p == '*' || *p == '?'))
+    nlit--;
+}
+
+static void
+compile(char *pattern)
+{
+  struct frag f;
+  int i, n;
+
+  n = strlen(pattern);
+  nfa = malloc((3*n + 8) * sizeof(nfa[0]));
+  sets = malloc((n + 1) * sizeof(sets[0]));
+  mark = malloc((3*n + 8) * sizeof(int));
+  list = malloc((3*n + 8) * sizeof(int));
+  stk = malloc(2 * (3*n + 8) * sizeof(int));
+  dfa = malloc(NDSTATE * sizeof(dfa[0]));
+  pool = malloc(NDSTATE * (3*n + 8) * sizeof(int));
+  if(!nfa || !sets || !mark || !list || !stk || !dfa || !pool)
+    fail("out of memory");
+  memset(mark, 0, (3*n + 8) * sizeof(int));
+
+  re = pattern;
+  f = alt();
+  if(*re)
+    fail("unmatched )");
+  nfa[f.end].out = newstate(NMATCH, -1);
+  nfastart = f.start;
 
-  for(i = 2; i < argc; i++){
-    if((fd = open(argv[i], 0)) < 0){
-      printf(1, "grep: cannot open %s\n", argv[i]);
-      exit();
+  if(pattern[0] != '^')
+    prefix(pattern);
+  for(i = 0; i < 256; i++)
+    skip[i] = nlit;
+  for(i = 0; i + 1 < nlit; i++)
+    skip[(uchar)lit[i]] = nlit - 1 - i;
+}
+
+// Add to list the states reachable from s without consuming
+// input.  NEOL states are kept, to be followed at end of line.
+static void
+closure(int s, int bol, int eol)
+{
+  int n;
+
+  n = 0;
+  stk[n++] = s;
+  while(n > 0){
+    s = stk[--n];
+    if(s < 0 || mark[s] == gen)
+      continue;
+    mark[s] = gen;
+    switch(nfa[s].op){
+    case NSPLIT:
+      stk[n++] = nfa[s].out1;
+      stk[n++] = nfa[s].out;
+      break;
+    case NNOP:
+      stk[n++] = nfa[s].out;
+      break;
+    case NBOL:
+      if(bol)
+        stk[n++] = nfa[s].out;
+      break;
+    case NEOL:
+      if(eol){
+        stk[n++] = nfa[s].out;
+        break;
+      }
+      list[nlist++] = s;
+      break;
+    default:
+      list[nlist++] = s;
     }
-    grep(pattern, fd);
-    close(fd);
   }
-  exit();
 }
 
-// Regexp matcher from Kernighan & Pike,
-// The Practice of Programming, Chapter 9.
+static void
+flush(void)
+{
+  ndfa = 0;
+  npool = 0;
+  nflush++;
+  dinit = -1;
+  memset(hashtab, 0xff, sizeof(hashtab));
+}
+
+// The DFA state for list, adding it to the cache.
+static int
+dstate(void)
+{
+  struct dstate *d;
+  int i, j, t;
+  uint h;
 
-int matchhere(char*, char*);
-int matchstar(int, char*, char*);
+  for(i = 1; i < nlist; i++)
+    for(j = i; j > 0 && list[j-1] > list[j]; j--){
+      t = list[j];
+      list[j] = list[j-1];
+      list[j-1] = t;
+    }
+  h = nlist;
+  for(i = 0; i < nlist; i++)
+    h = h * 31 + list[i];
+  h &= NHASH - 1;
+  for(i = hashtab[h]; i >= 0; i = dfa[i].hnext){
+    if(dfa[i].n != nlist)
+      continue;
+    for(j = 0; j < nlist && dfa[i].nfa[j] == list[j]; j++)
+      ;
+    if(j == nlist)
+      return i;
+  }
 
-int
-match(char *re, char *text)
+  if(ndfa == NDSTATE)
+    flush();
+  d = &dfa[ndfa];
+  d->nfa = pool + npool;
+  npool += nlist;
+  d->n = nlist;
+  memmove(d->nfa, list, nlist * sizeof(int));
+  memset(d->next, 0xff, sizeof(d->next));
+  d->accept = d->acceptend = 0;
+  // With no states left, not even the pattern's start can be
+  // reached (it is anchored by ^).
+  d->dead = nlist == 0;
+  for(i = 0; i < nlist; i++)
+    if(nfa[list[i]].op == NMATCH)
+      d->accept = 1;
+  // Follow the $ states to see if the line could end here.
+  gen++;
+  nlist = 0;
+  for(i = 0; i < d->n; i++)
+    if(nfa[d->nfa[i]].op == NEOL)
+      closure(nfa[d->nfa[i]].out, 0, 1);
+  for(i = 0; i < nlist; i++)
+    if(nfa[list[i]].op == NMATCH)
+      d->acceptend = 1;
+  d->hnext = hashtab[h];
+  hashtab[h] = ndfa;
+  return ndfa++;
+}
+
+static int
+initstate(void)
 {
-  if(re[0] == '^')
-    return matchhere(re+1, text);
-  do{  // must look at empty string
-    if(matchhere(re, text))
-      return 1;
-  }while(*text++ != '\0');
-  return 0;
+  if(dinit < 0){
+    gen++;
+    nlist = 0;
+    closure(nfastart, 1, 0);
+    dinit = dstate();
+  }
+  return dinit;
 }
 
-// matchhere: search for re at beginning of text
-int matchhere(char *re, char *text)
+// The state after d reads c.
+static int
+step(int d, int c)
 {
-  if(re[0] == '\0')
-    return 1;
-  if(re[1] == '*')
-    return matchstar(re[0], re+2, text);
-  if(re[0] == '$' && re[1] == '\0')
-    return *text == '\0';
-  if(*text!='\0' && (re[0]=='.' || re[0]==*text))
-    return matchhere(re+1, text+1);
-  return 0;
+  struct dstate *ds;
+  int i, s, n, f;
+
+  ds = &dfa[d];
+  gen++;
+  nlist = 0;
+  for(i = 0; i < ds->n; i++){
+    s = ds->nfa[i];
+    if(nfa[s].op == NCHAR && hasbit(nfa[s].set, c))
+      closure(nfa[s].out, 0, 0);
+  }
+  // A match may start anywhere.
+  closure(nfastart, 0, 0);
+  f = nflush;
+  n = dstate();
+  // Unless dstate() just flushed the cache, d is still valid.
+  if(nflush == f)
+    dfa[d].next[c] = n;
+  return n;
 }
 
-// matchstar: search for c*re at beginning of text
-int matchstar(int c, char *re, char *text)
+// Does the line [p, e) match?
+static int
+matchline(char *p, char *e)
 {
-  do{  // a * matches zero or more instances
-    if(matchhere(re, text))
+  struct dstate *d;
+  int s, n;
+
+  s = initstate();
+  for(; p < e; p++){
+    d = &dfa[s];
+    if(d->accept)
       return 1;
-  }while(*text!='\0' && (*text++==c || c=='.'));
+    if(d->dead)
+      return 0;
+    if((n = d->next[(uchar)*p]) < 0)
+      n = step(s, (uchar)*p);
+    s = n;
+  }
+  return dfa[s].accept || dfa[s].acceptend;
+}
+
+// First occurrence of the literal prefix in [p, e), or 0.
+static char*
+findlit(char *p, char *e)
+{
+  char *q;
+  int i;
+
+  if(nlit == 1)
+    return memchr(p, lit[0], e - p);
+  for(q = p; q + nlit <= e; q += skip[(uchar)q[nlit-1]]){
+    for(i = nlit - 1; i >= 0 && q[i] == lit[i]; i--)
+      ;
+    if(i < 0)
+      return q;
+  }
   return 0;
 }
 
+static int
+countnl(char *p, char *e)
+{
+  int n;
+
+  for(n = 0; p < e; p++)
+    if(*p == '\n')
+      n++;
+  return n;
+}
+
+void
+grep(char *name, int fd)
+{
+  int n, m, lineno, count;
+  char *p, *q, *e, *end, *nbuf;
+
+  m = lineno = count = 0;
+  for(;;){
+    if(m == bufsize){
+      // A line longer than the buffer: grow it.
+      if((nbuf = malloc(2*bufsize + 1)) == 0)
+        fail("out of memory");
+      memmove(nbuf, buf, m);
+      free(buf);
+      buf = nbuf;
+      bufsize *= 2;
+    }
+    n = read(fd, buf + m, bufsize - m);
+    if(n < 0){
+      printf(2, "grep: read error\n");
+      break;
+    }
+    m += n;
+    // Search whole lines only; a final line may lack its newline.
+    if(n == 0 && m > 0 && buf[m-1] != '\n')
+      buf[m++] = '\n';
+    for(end = buf + m; end > buf && end[-1] != '\n'; end--)
+      ;
+
+    p = buf;
+    while(p < end){
+      if(nlit > 0 && !vflag){
+        if((q = findlit(p, end)) == 0){
+          if(nflag)
+            lineno += countnl(p, end);
+          p = end;
+          break;
+        }
+        while(q > p && q[-1] != '\n')
+          q--;
+        if(nflag)
+          lineno += countnl(p, q);
+        p = q;
+      }
+      e = memchr(p, '\n', end - p);
+      lineno++;
+      if(matchline(p, e) != vflag){
+        count++;
+        if(!cflag){
+          if(multi)
+            printf(1, "%s:", name);
+          if(nflag)
+            printf(1, "%d:", lineno);
+          *e = 0;
+          printf(1, "%s\n", p);
+          *e = '\n';
+        }
+      }
+      p = e + 1;
+    }
+    m -= end - buf;
+    memmove(buf, end, m);
+    if(n == 0)
+      break;
+  }
+  if(cflag){
+    if(multi)
+      printf(1, "%s:", name);
+    printf(1, "%d\n", count);
+  }
+}
+
+void
+grepfile(char *name)
+{
+  int fd;
+
+  if((fd = open(name, O_RDONLY)) < 0){
+    printf(2, "grep: cannot open %s\n", name);
+    return;
+  }
+  grep(name, fd);
+  close(fd);
+}
+
+// Search name in a child writing to a pipe; return the pipe's
+// read end.
+int
+spawn(char *name)
+{
+  int p[2];
+
+  if(pipe(p) < 0)
+    fail("pipe failed");
+  switch(fork()){
+  case -1:
+    fail("fork failed");
+  case 0:
+    close(p[0]);
+    close(1);
+    dup(p[1]);
+    close(p[1]);
+    grepfile(name);
+    exit();
+  }
+  close(p[1]);
+  return p[0];
+}
+
+void
+parallel(char **files, int nfiles, int jobs)
+{
+  int fds[MAXJOBS], started, done, n;
+
+  started = done = 0;
+  while(done < nfiles){
+    while(started < nfiles && started - done < jobs){
+      fds[started % jobs] = spawn(files[started]);
+      started++;
+    }
+    while((n = read(fds[done % jobs], buf, bufsize)) > 0)
+      write(1, buf, n);
+    close(fds[done % jobs]);
+    wait();
+    done++;
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  int i, jobs;
+  char *p;
+
+  jobs = 1;
+  for(i = 1; i < argc && argv[i][0] == '-' && argv[i][1]; i++){
+    if(strcmp(argv[i], "-j") == 0 && i + 1 < argc){
+      jobs = atoi(argv[++i]);
+      continue;
+    }
+    for(p = argv[i] + 1; *p; p++){
+      if(*p == 'c')
+        cflag = 1;
+      else if(*p == 'n')
+        nflag = 1;
+      else if(*p == 'v')
+        vflag = 1;
+      else
+        i = argc;
+    }
+  }
+  if(i >= argc || jobs < 1){
+    printf(2, "usage: grep [-cnv] [-j jobs] pattern [file ...]\n");
+    exit();
+  }
+  if(jobs > MAXJOBS)
+    jobs = MAXJOBS;
+
+  compile(argv[i++]);
+  flush();
+  bufsize = BUFSIZE;
+  if((buf = malloc(bufsize + 1)) == 0)
+    fail("out of memory");
+
+  if(i == argc){
+    grep("", 0);
+    exit();
+  }
+  multi = argc - i > 1;
+  if(jobs > 1 && multi)
+    parallel(argv + i, argc - i, jobs);
+  else
+    for(; i < argc; i++)
+      grepfile(argv[i]);
+  exit();
+}
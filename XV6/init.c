@@ -6,6 +6,7 @@
 #include "fcntl.h"
 
 char *argv[] = { "sh", 0 };
+char *auditdargv[] = { "auditd", 0 };
 
 int
 main(void)
@@ -25,6 +26,14 @@ main(void)
   printf(1, "o- SadraAbbasi\n");
   printf(1, "o- MohammadTaghizadeh\n");
 
+  // The audit daemon runs for as long as the system does.
+  pid = fork();
+  if(pid == 0){
+    exec("auditd", auditdargv);
+    printf(1, "init: exec auditd failed\n");
+    exit();
+  }
+
   for(;;){
     printf(1, "init: starting sh\n");
     pid = fork();
@@ -33,6 +42,9 @@ main(void)
       exit();
     }
     if(pid == 0){
+      // Each console shell is a login session of its own.
+      if(setsid() < 0)
+        printf(1, "init: setsid failed\n");
       exec("sh", argv);
       printf(1, "init: exec sh failed\n");
       exit();
@@ -0,0 +1,191 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+#include "prof.h"
+
+#define KERNBASE 0x80000000
+#define NBATCH 128
+#define NPIDS 32
+#define NTOP 20
+
+struct sym {
+    uint addr;
+    char *name;
+    uint hits;
+};
+
+static struct profsample buf[NBATCH];
+static struct sym *syms;
+static int nsym;
+
+static int pids[NPIDS];
+static uint pidhits[NPIDS];
+static int npid;
+
+// Load the "address name" lines of kernel.sym,
+// keeping kernel addresses sorted by address.
+void loadsyms(void) {
+    struct stat st;
+    struct sym t;
+    char *data, *p, *q;
+    int fd, i, j, n;
+
+    if((fd = open("/kernel.sym", O_RDONLY)) < 0 || fstat(fd, &st) < 0) {
+        printf(2, "kprof: cannot open /kernel.sym\n");
+        return;
+    }
+    data = malloc(st.size + 1);
+    n = 0;
+    while(n < st.size && (i = read(fd, data + n, st.size - n)) > 0)
+        n += i;
+    close(fd);
+    data[n] = '\0';
+
+    for(i = 0, p = data; *p; p++)
+        if(*p == '\n')
+            i++;
+    syms = malloc((i + 1) * sizeof(struct sym));
+
+    for(p = data; *p; p = q) {
+        t.addr = 0;
+        for(; *p && *p != ' ' && *p != '\n'; p++) {
+            t.addr <<= 4;
+            if(*p >= '0' && *p <= '9')
+                t.addr |= *p - '0';
+            else if(*p >= 'a' && *p <= 'f')
+                t.addr |= *p - 'a' + 10;
+        }
+        if(*p == ' ')
+            p++;
+        for(q = p; *q && *q != '\n'; q++)
+            ;
+        if(*q)
+            *q++ = '\0';
+        if(t.addr < KERNBASE || *p == '\0')
+            continue;
+        t.name = p;
+        t.hits = 0;
+        for(j = nsym++; j > 0 && syms[j-1].addr > t.addr; j--)
+            syms[j] = syms[j-1];
+        syms[j] = t;
+    }
+}
+
+// The symbol containing kernel address eip, or 0.
+struct sym* lookup(uint eip) {
+    int lo, hi, mid;
+
+    lo = 0;
+    hi = nsym;
+    while(lo < hi) {
+        mid = (lo + hi) / 2;
+        if(syms[mid].addr <= eip)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo > 0 ? &syms[lo-1] : 0;
+}
+
+void countuser(int pid) {
+    int i;
+
+    for(i = 0; i < npid; i++)
+        if(pids[i] == pid)
+            break;
+    if(i == npid) {
+        if(npid == NPIDS)
+            return;
+        pids[npid++] = pid;
+    }
+    pidhits[i]++;
+}
+
+void report(void) {
+    struct profsample *s;
+    struct sym *sy;
+    uint lost, total, unknown, kernel, best;
+    int i, j, n, top;
+
+    loadsyms();
+    total = kernel = unknown = 0;
+    while((n = profread(buf, NBATCH, &lost)) > 0 || lost > 0) {
+        if(lost > 0)
+            printf(1, "kprof: %d samples lost\n", lost);
+        for(i = 0; i < n; i++) {
+            s = &buf[i];
+            total++;
+            if(s->user) {
+                countuser(s->pid);
+                continue;
+            }
+            kernel++;
+            if((sy = lookup(s->eip)) != 0)
+                sy->hits++;
+            else
+                unknown++;
+        }
+    }
+    if(total == 0) {
+        printf(1, "kprof: no samples\n");
+        return;
+    }
+
+    printf(1, "%d samples, %d kernel, %d user\n", total, kernel, total - kernel);
+    printf(1, "\nkernel\n%%\tsamples\tfunction\n");
+    for(top = 0; top < NTOP; top++) {
+        // Selection of the next hottest symbol; nsym is small.
+        best = 0;
+        j = -1;
+        for(i = 0; i < nsym; i++) {
+            if(syms[i].hits > best) {
+                best = syms[i].hits;
+                j = i;
+            }
+        }
+        if(j < 0)
+            break;
+        printf(1, "%d\t%d\t%s\n", best * 100 / total, best, syms[j].name);
+        syms[j].hits = 0;
+    }
+    if(unknown > 0)
+        printf(1, "%d\t%d\t(unknown)\n", unknown * 100 / total, unknown);
+
+    if(npid > 0) {
+        printf(1, "\nuser\n%%\tsamples\tpid\n");
+        for(i = 0; i < npid; i++)
+            printf(1, "%d\t%d\t%d\n", pidhits[i] * 100 / total, pidhits[i], pids[i]);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int period;
+
+    if(argc < 2) {
+        printf(2, "usage: kprof start [period] | stop | report | command [args...]\n");
+        exit();
+    }
+
+    if(strcmp(argv[1], "start") == 0) {
+        period = argc > 2 ? atoi(argv[2]) : 1;
+        if(profstart(period) < 0)
+            printf(2, "kprof: bad period %d\n", period);
+    } else if(strcmp(argv[1], "stop") == 0) {
+        profstop();
+    } else if(strcmp(argv[1], "report") == 0) {
+        report();
+    } else {
+        // Profile one command from start to finish.
+        profstart(1);
+        if(fork() == 0) {
+            exec(argv[1], argv + 1);
+            printf(2, "kprof: exec %s failed\n", argv[1]);
+            exit();
+        }
+        wait();
+        profstop();
+        report();
+    }
+    exit();
+}
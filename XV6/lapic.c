@@ -227,3 +227,31 @@ cmostime(struct rtcdate *r)
   *r = t1;
   r->year += 2000;
 }
+
+// Seconds since 2000-01-01 00:00 in the RTC's time zone.  The
+// RTC is read only the first time; after that the time is
+// advanced from ticks, at 100 a second, which is cheap enough to
+// stamp every inode change with.
+uint
+epochtime(void)
+{
+  static uint base, baseticks;
+  static volatile int valid;
+  static uchar mdays[] = { 0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+  struct rtcdate r;
+  uint y, m, days;
+
+  if(!valid){
+    cmostime(&r);
+    days = r.day - 1;
+    for(y = 2000; y < r.year; y++)
+      days += y % 4 == 0 ? 366 : 365;
+    for(m = 1; m < r.month && m <= 12; m++)
+      days += mdays[m] + (m == 2 && r.year % 4 == 0);
+    baseticks = ticks;
+    base = ((days*24 + r.hour)*60 + r.minute)*60 + r.second;
+    __sync_synchronize();
+    valid = 1;
+  }
+  return base + (ticks - baseticks) / 100;
+}
@@ -0,0 +1,486 @@
+// Line diff of two files.
+//
+// Each file is read a page at a time, holding its inode lock
+// only for the readi, and split into lines, of which only a hash
+// and the starting offset are kept.  Lines with different hashes
+// differ; lines with equal hashes are compared byte by byte,
+// reading them back from the files.  Myers' O(ND) algorithm, in its linear-space
+// form (E. Myers, "An O(ND) Difference Algorithm and Its
+// Variations", 1986), finds a longest common subsequence by
+// repeatedly splitting at the middle snake of each subproblem,
+// marking every line it matches.  The unmatched lines are then
+// printed as unified diff hunks without context (diff -U0) into
+// the caller's buffer, re-reading their text from the files.
+//
+// Arrays can be as long as the longest file has lines, more than
+// fits in a page, so they are built from separately kalloc'd
+// pages.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "mmu.h"
+#include "fs.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "file.h"
+#include "stat.h"
+
+#define MAXLINES  (MAXFILE*BSIZE + 1)
+#define PGWORDS   (PGSIZE / sizeof(uint))
+#define VECPAGES  ((2*MAXLINES + 4 + PGWORDS - 1) / PGWORDS)
+#define NSPLIT    64          // Subproblem stack; depth is O(log D)
+#define MATCHED   0x80000000  // Set in a line's offset word
+
+#define FNVBASIS  2166136261U
+#define FNVPRIME  16777619U
+
+// An array of up to VECPAGES*PGWORDS words.
+struct vec {
+  uint *pg[VECPAGES];
+};
+
+// A file's lines: word 2i is line i's hash and word 2i+1 its
+// offset, plus MATCHED; word 2n+1 is the file's length.
+struct text {
+  struct inode *ip;
+  uint n;
+  int nonl;                   // Last line has no newline
+  struct vec v;
+};
+
+struct split {
+  uint a, n;                  // Lines [a, a+n) of the first file
+  uint b, m;                  // Lines [b, b+m) of the second
+};
+
+struct diff {
+  struct text t[2];
+  struct vec fwd, rev;        // Furthest x on each diagonal
+  struct split stack[NSPLIT];
+  char *page;                 // Scratch for comparing lines
+  char *out;                  // Caller's buffer
+  int nout;
+  int len;                    // Bytes of output, even if not stored
+};
+
+static uint*
+vat(struct vec *v, uint i)
+{
+  return &v->pg[i / PGWORDS][i % PGWORDS];
+}
+
+// Make words [0, n) of v usable.
+static int
+vgrow(struct vec *v, uint n)
+{
+  uint i;
+
+  if(n > VECPAGES * PGWORDS)
+    return -1;
+  for(i = 0; i < (n + PGWORDS - 1) / PGWORDS; i++)
+    if(v->pg[i] == 0 && (v->pg[i] = (uint*)kalloc()) == 0)
+      return -1;
+  return 0;
+}
+
+static void
+vfree(struct vec *v)
+{
+  int i;
+
+  for(i = 0; i < VECPAGES; i++)
+    if(v->pg[i])
+      kfree((char*)v->pg[i]);
+}
+
+static uint
+hash(struct text *t, uint i)
+{
+  return *vat(&t->v, 2*i);
+}
+
+static uint
+lineoff(struct text *t, uint i)
+{
+  return *vat(&t->v, 2*i + 1) & ~MATCHED;
+}
+
+static int
+matched(struct text *t, uint i)
+{
+  return (*vat(&t->v, 2*i + 1) & MATCHED) != 0;
+}
+
+// Length of line i of t, without its newline.
+static uint
+linelen(struct text *t, uint i)
+{
+  uint n;
+
+  n = lineoff(t, i+1) - lineoff(t, i);
+  if(i < t->n - 1 || !t->nonl)
+    n--;
+  return n;
+}
+
+static int
+readline(struct inode *ip, char *buf, uint off, uint n)
+{
+  int r;
+
+  ilock(ip);
+  r = readi(ip, buf, off, n);
+  iunlock(ip);
+  return r;
+}
+
+// Is line a of the first file the same as line b of the second?
+static int
+same(struct diff *d, uint a, uint b)
+{
+  struct text *A = &d->t[0], *B = &d->t[1];
+  char *p = d->page, *q = d->page + PGSIZE/2;
+  uint n, k, m, oa, ob;
+
+  if(hash(A, a) != hash(B, b) || (n = linelen(A, a)) != linelen(B, b))
+    return 0;
+  oa = lineoff(A, a);
+  ob = lineoff(B, b);
+  for(k = 0; k < n; k += m){
+    m = n - k < PGSIZE/2 ? n - k : PGSIZE/2;
+    if(readline(A->ip, p, oa + k, m) != m || readline(B->ip, q, ob + k, m) != m ||
+       memcmp(p, q, m) != 0)
+      return 0;
+  }
+  return 1;
+}
+
+static void
+match(struct diff *d, uint a, uint b)
+{
+  *vat(&d->t[0].v, 2*a + 1) |= MATCHED;
+  *vat(&d->t[1].v, 2*b + 1) |= MATCHED;
+}
+
+static int
+addline(struct text *t, uint off, uint h)
+{
+  if(t->n >= MAXLINES || vgrow(&t->v, 2*t->n + 4) < 0)
+    return -1;
+  *vat(&t->v, 2*t->n) = h;
+  *vat(&t->v, 2*t->n + 1) = off;
+  t->n++;
+  return 0;
+}
+
+// Read t's file through buf, a page, hashing each line.
+static int
+readtext(struct text *t, char *buf)
+{
+  uint off, start, h;
+  int i, n;
+
+  off = start = 0;
+  h = FNVBASIS;
+  for(;;){
+    ilock(t->ip);
+    n = readi(t->ip, buf, off, PGSIZE);
+    iunlock(t->ip);
+    if(n <= 0)
+      break;
+    for(i = 0; i < n; i++){
+      if(buf[i] == '\n'){
+        if(addline(t, start, h) < 0)
+          return -1;
+        start = off + i + 1;
+        h = FNVBASIS;
+      } else
+        h = (h ^ (uchar)buf[i]) * FNVPRIME;
+    }
+    off += n;
+  }
+  if(n < 0)
+    return -1;
+  if(start < off){
+    if(addline(t, start, h) < 0)
+      return -1;
+    t->nonl = 1;
+  }
+  if(vgrow(&t->v, 2*t->n + 2) < 0)
+    return -1;
+  *vat(&t->v, 2*t->n + 1) = off;
+  return 0;
+}
+
+// Find the middle snake of s: the diagonal run at the midpoint
+// of a shortest edit script, from (*x, *y) to (*u, *v) relative
+// to s's origin.  Returns the script's length D.
+static int
+midsnake(struct diff *d, struct split *s, uint *x, uint *y, uint *u, uint *v)
+{
+  int n = s->n, m = s->m, delta = n - m, odd = delta & 1;
+  int max = (n + m + 1) / 2, off = max + 1;
+  int e, k, px, py, sx, sy;
+
+  *vat(&d->fwd, off + 1) = 0;
+  *vat(&d->rev, off + 1) = 0;
+  for(e = 0; e <= max; e++){
+    for(k = -e; k <= e; k += 2){
+      if(k == -e || (k != e && *vat(&d->fwd, off+k-1) < *vat(&d->fwd, off+k+1)))
+        px = *vat(&d->fwd, off+k+1);
+      else
+        px = *vat(&d->fwd, off+k-1) + 1;
+      py = px - k;
+      sx = px;
+      sy = py;
+      while(px < n && py < m && same(d, s->a+px, s->b+py)){
+        px++;
+        py++;
+      }
+      *vat(&d->fwd, off+k) = px;
+      if(odd && k >= delta-(e-1) && k <= delta+(e-1) &&
+         px + *vat(&d->rev, off+delta-k) >= n){
+        *x = sx; *y = sy; *u = px; *v = py;
+        return 2*e - 1;
+      }
+    }
+    // Backward, in coordinates counted from the far corner.
+    for(k = -e; k <= e; k += 2){
+      if(k == -e || (k != e && *vat(&d->rev, off+k-1) < *vat(&d->rev, off+k+1)))
+        px = *vat(&d->rev, off+k+1);
+      else
+        px = *vat(&d->rev, off+k-1) + 1;
+      py = px - k;
+      sx = px;
+      sy = py;
+      while(px < n && py < m && same(d, s->a+n-1-px, s->b+m-1-py)){
+        px++;
+        py++;
+      }
+      *vat(&d->rev, off+k) = px;
+      if(!odd && delta-k >= -e && delta-k <= e &&
+         px + *vat(&d->fwd, off+delta-k) >= n){
+        *x = n - px; *y = m - py; *u = n - sx; *v = m - sy;
+        return 2*e;
+      }
+    }
+  }
+  panic("midsnake");
+}
+
+// Mark the lines of a longest common subsequence.
+static int
+lcs(struct diff *d)
+{
+  struct text *A = &d->t[0], *B = &d->t[1];
+  struct split s, *sp = d->stack;
+  uint x, y, u, v, i;
+  int e;
+
+  if(vgrow(&d->fwd, A->n + B->n + 4) < 0 || vgrow(&d->rev, A->n + B->n + 4) < 0)
+    return -1;
+  sp->a = 0; sp->n = A->n;
+  sp->b = 0; sp->m = B->n;
+  sp++;
+  while(sp > d->stack){
+    s = *--sp;
+    // Common prefix and suffix.
+    while(s.n > 0 && s.m > 0 && same(d, s.a, s.b)){
+      match(d, s.a++, s.b++);
+      s.n--;
+      s.m--;
+    }
+    while(s.n > 0 && s.m > 0 && same(d, s.a+s.n-1, s.b+s.m-1)){
+      match(d, s.a+s.n-1, s.b+s.m-1);
+      s.n--;
+      s.m--;
+    }
+    if(s.n == 0 || s.m == 0)
+      continue;
+    e = midsnake(d, &s, &x, &y, &u, &v);
+    if(e <= 1){
+      // At most one insertion or deletion: skip it greedily.
+      while(s.n > 0 && s.m > 0){
+        if(same(d, s.a, s.b)){
+          match(d, s.a++, s.b++);
+          s.n--;
+          s.m--;
+        } else if(s.n > s.m){
+          s.a++;
+          s.n--;
+        } else {
+          s.b++;
+          s.m--;
+        }
+      }
+      continue;
+    }
+    if(sp + 2 > d->stack + NSPLIT)
+      return -1;
+    for(i = 0; i < u - x; i++)
+      match(d, s.a+x+i, s.b+y+i);
+    sp->a = s.a; sp->n = x;
+    sp->b = s.b; sp->m = y;
+    sp++;
+    sp->a = s.a+u; sp->n = s.n-u;
+    sp->b = s.b+v; sp->m = s.m-v;
+    sp++;
+  }
+  return 0;
+}
+
+static void
+emit(struct diff *d, char *s, int n)
+{
+  if(d->len < d->nout)
+    memmove(d->out + d->len, s, n < d->nout - d->len ? n : d->nout - d->len);
+  d->len += n;
+}
+
+static void
+emitnum(struct diff *d, uint x)
+{
+  char buf[16];
+  int i;
+
+  i = sizeof(buf);
+  do {
+    buf[--i] = '0' + x % 10;
+  } while((x /= 10) != 0);
+  emit(d, buf + i, sizeof(buf) - i);
+}
+
+// Emit "start,count" as diff does: the line before an empty
+// range, and no count of 1.
+static void
+emitrange(struct diff *d, uint start, uint count)
+{
+  emitnum(d, count ? start + 1 : start);
+  if(count != 1){
+    emit(d, ",", 1);
+    emitnum(d, count);
+  }
+}
+
+// Emit line i of t, after c.
+static void
+emitline(struct diff *d, struct text *t, uint i, char c)
+{
+  uint off, n, room;
+  int r;
+
+  emit(d, &c, 1);
+  off = lineoff(t, i);
+  n = lineoff(t, i+1) - off;
+  if(d->len < d->nout){
+    room = d->nout - d->len;
+    if(room > n)
+      room = n;
+    ilock(t->ip);
+    r = readi(t->ip, d->out + d->len, off, room);
+    iunlock(t->ip);
+    // Blank out what the file lost since it was read.
+    if(r < 0)
+      r = 0;
+    if(r < room)
+      memset(d->out + d->len + r, ' ', room - r);
+  }
+  d->len += n;
+  if(i == t->n - 1 && t->nonl)
+    emit(d, "\n", 1);
+}
+
+static void
+hunks(struct diff *d)
+{
+  struct text *A = &d->t[0], *B = &d->t[1];
+  uint i, j, i0, j0;
+
+  i = j = 0;
+  while(i < A->n || j < B->n){
+    if(i < A->n && j < B->n && matched(A, i) && matched(B, j)){
+      i++;
+      j++;
+      continue;
+    }
+    i0 = i;
+    j0 = j;
+    while(i < A->n && !matched(A, i))
+      i++;
+    while(j < B->n && !matched(B, j))
+      j++;
+    emit(d, "@@ -", 4);
+    emitrange(d, i0, i - i0);
+    emit(d, " +", 2);
+    emitrange(d, j0, j - j0);
+    emit(d, " @@\n", 4);
+    for(; i0 < i; i0++)
+      emitline(d, A, i0, '-');
+    for(; j0 < j; j0++)
+      emitline(d, B, j0, '+');
+  }
+}
+
+// Write the differences between file1 and file2 to buf, as far
+// as n bytes go.  Returns the length of the whole diff, which is
+// 0 if the files are the same, or -1.
+int
+diff(char *file1, char *file2, char *buf, int n)
+{
+  struct diff *d;
+  struct text *t;
+  char *page;
+  int i, r;
+
+  if(sizeof(struct diff) > PGSIZE)
+    panic("diff: struct diff too big");
+  if((d = (struct diff*)kalloc()) == 0)
+    return -1;
+  if((page = kalloc()) == 0){
+    kfree((char*)d);
+    return -1;
+  }
+  memset(d, 0, sizeof(*d));
+  d->out = buf;
+  d->nout = n;
+
+  r = -1;
+  begin_op();
+  d->t[0].ip = namei(file1);
+  d->t[1].ip = namei(file2);
+  end_op();
+  for(i = 0; i < 2; i++){
+    t = &d->t[i];
+    if(t->ip == 0)
+      goto bad;
+    ilock(t->ip);
+    r = t->ip->type;
+    iunlock(t->ip);
+    if(r == T_DEV || readtext(t, page) < 0){
+      r = -1;
+      goto bad;
+    }
+  }
+  r = -1;
+  d->page = page;
+  if(lcs(d) < 0)
+    goto bad;
+  hunks(d);
+  r = d->len;
+
+bad:
+  begin_op();
+  for(i = 0; i < 2; i++){
+    t = &d->t[i];
+    if(t->ip)
+      iput(t->ip);
+    vfree(&t->v);
+  }
+  end_op();
+  vfree(&d->fwd);
+  vfree(&d->rev);
+  kfree(page);
+  kfree((char*)d);
+  return r;
+}
@@ -0,0 +1,62 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define MAXPROCS 16
+
+// Run n processes hammering one kernel lock for nticks ticks.
+void run(int ticketed, int n, int nticks) {
+    int fd[2], i, c, start, total, min, max;
+
+    if(pipe(fd) < 0) {
+        printf(2, "lockbench: pipe failed\n");
+        exit();
+    }
+    // Give every child time to start before the clock does.
+    start = uptime() + 2;
+    for(i = 0; i < n; i++) {
+        if(fork() == 0) {
+            close(fd[0]);
+            c = lockbench(ticketed, start, start + nticks);
+            write(fd[1], &c, sizeof(c));
+            exit();
+        }
+    }
+    close(fd[1]);
+
+    total = 0;
+    min = max = -1;
+    for(i = 0; i < n && read(fd[0], &c, sizeof(c)) == sizeof(c); i++) {
+        total += c;
+        if(min < 0 || c < min)
+            min = c;
+        if(c > max)
+            max = c;
+    }
+    close(fd[0]);
+    for(i = 0; i < n; i++)
+        wait();
+
+    printf(1, "%s\t%d\t%d\t%d\t%d\t%d%%\n", ticketed ? "ticket" : "xchg",
+           n, total / nticks, min, max, max > 0 ? min * 100 / max : 0);
+}
+
+int main(int argc, char* argv[]) {
+    int n, maxprocs, nticks;
+
+    maxprocs = argc > 1 ? atoi(argv[1]) : 4;
+    nticks = argc > 2 ? atoi(argv[2]) : 100;
+    if(maxprocs < 1 || maxprocs > MAXPROCS || nticks < 1) {
+        printf(2, "usage: lockbench [maxprocs] [ticks]\n");
+        exit();
+    }
+
+    // rate is acquisitions per tick by all processes; min and
+    // max are per-process totals; fairness is min as a share of max.
+    printf(1, "lock\tprocs\trate\tmin\tmax\tfairness\n");
+    for(n = 1; n <= maxprocs; n++) {
+        run(0, n, nticks);
+        run(1, n, nticks);
+    }
+    exit();
+}
@@ -0,0 +1,198 @@
+// Lock contention statistics.
+//
+// Statistics are kept per lock class: all locks initialized
+// with the same name (every pipe's lock, every inode's sleep
+// lock, ...) share one class, so locks that are freed never
+// leave dangling entries behind.  Each class keeps a slot per
+// CPU, updated only by that CPU with interrupts off, so the
+// counters need no lock of their own.
+//
+// Collection is off until turned on with lockstat(LOCKSTAT_ON);
+// while it is off, acquire() and release() only test lockstat_on.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "x86.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "proc.h"
+#include "spinlock.h"
+#include "lockstat.h"
+
+struct lockcpu {
+  uint acquire;
+  uint contended;
+  uint64 wait;
+  uint64 maxwait;
+  uint64 hold;
+  uint64 maxhold;
+  uint spin;
+  uint spinok;
+};
+
+struct lockclass {
+  char *name;
+  int sleep;
+  int nlocks;
+  struct lockcpu cpu[NCPU];
+};
+
+static struct lockclass classes[NLOCKCLASS];
+static int nclass;
+
+// Protects classes[] and nclass.  kinit1() calls initlock()
+// before mpinit() has found the CPUs, when neither acquire() nor
+// pushcli() can use mycpu() yet, so this is an xchg lock that
+// saves and clears the interrupt flag itself.  With interrupts
+// off, a handler on the same CPU cannot spin on it forever.
+// Being no spinlock, it does not show up in lockstat.
+static uint classlock;
+
+static uint
+classacquire(void)
+{
+  uint eflags;
+
+  eflags = readeflags();
+  cli();
+  while(xchg(&classlock, 1) != 0)
+    pause();
+  return eflags;
+}
+
+static void
+classrelease(uint eflags)
+{
+  xchg(&classlock, 0);
+  if(eflags & FL_IF)
+    sti();
+}
+
+int lockstat_on;
+
+// Return the class for locks named name, creating it if needed.
+// Returns 0 if the table is full; such locks are not measured.
+struct lockclass*
+lockclass(char *name, int sleep)
+{
+  struct lockclass *c;
+  uint eflags;
+
+  if(name == 0)
+    return 0;
+  eflags = classacquire();
+  for(c = classes; c < &classes[nclass]; c++)
+    if(c->sleep == sleep && (c->name == name || strncmp(c->name, name, 16) == 0))
+      break;
+  if(c == &classes[nclass]){
+    if(nclass == NLOCKCLASS){
+      classrelease(eflags);
+      return 0;
+    }
+    nclass++;
+    c->name = name;
+    c->sleep = sleep;
+  }
+  c->nlocks++;
+  classrelease(eflags);
+  return c;
+}
+
+// Account an acquisition of a lock of class c that waited
+// wait cycles.  Caller must have interrupts off.
+void
+lockstat_acquired(struct lockclass *c, uint64 wait, int contended)
+{
+  struct lockcpu *s = &c->cpu[cpuid()];
+
+  s->acquire++;
+  if(contended)
+    s->contended++;
+  s->wait += wait;
+  if(wait > s->maxwait)
+    s->maxwait = wait;
+}
+
+// Account a sleep lock acquirer that spun on a running owner;
+// ok is set if the lock was then free.
+// Caller must have interrupts off.
+void
+lockstat_spun(struct lockclass *c, int ok)
+{
+  struct lockcpu *s = &c->cpu[cpuid()];
+
+  s->spin++;
+  if(ok)
+    s->spinok++;
+}
+
+// Account a release of a lock of class c held hold cycles.
+// Caller must have interrupts off.
+void
+lockstat_released(struct lockclass *c, uint64 hold)
+{
+  struct lockcpu *s = &c->cpu[cpuid()];
+
+  s->hold += hold;
+  if(hold > s->maxhold)
+    s->maxhold = hold;
+}
+
+// Copy statistics for up to n classes into buf.
+// Return the number of classes copied.
+static int
+lockstat_read(struct lockinfo *buf, int n)
+{
+  struct lockclass *c;
+  struct lockcpu *s;
+  struct lockinfo *li;
+  int i, k;
+
+  for(i = 0; i < n && i < nclass; i++){
+    c = &classes[i];
+    li = &buf[i];
+    memset(li, 0, sizeof(*li));
+    safestrcpy(li->name, c->name, sizeof(li->name));
+    li->sleep = c->sleep;
+    li->nlocks = c->nlocks;
+    for(k = 0; k < ncpu; k++){
+      s = &c->cpu[k];
+      li->acquire += s->acquire;
+      li->contended += s->contended;
+      li->wait += s->wait;
+      li->hold += s->hold;
+      li->spin += s->spin;
+      li->spinok += s->spinok;
+      if(s->maxwait > li->maxwait)
+        li->maxwait = s->maxwait;
+      if(s->maxhold > li->maxhold)
+        li->maxhold = s->maxhold;
+    }
+  }
+  return i;
+}
+
+int
+lockstat(int cmd, struct lockinfo *buf, int n)
+{
+  int i;
+
+  switch(cmd){
+  case LOCKSTAT_READ:
+    return lockstat_read(buf, n);
+  case LOCKSTAT_ON:
+    lockstat_on = 1;
+    return 0;
+  case LOCKSTAT_OFF:
+    lockstat_on = 0;
+    return 0;
+  case LOCKSTAT_RESET:
+    // Racy against CPUs updating their slots, which is fine
+    // for statistics.
+    for(i = 0; i < nclass; i++)
+      memset(classes[i].cpu, 0, sizeof(classes[i].cpu));
+    return 0;
+  }
+  return -1;
+}
@@ -0,0 +1,68 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "lockstat.h"
+
+#define NINFO 64
+#define NTOP 15
+
+static struct lockinfo info[NINFO];
+
+// Cycles in units of 1024, which fits in an int for printf.
+int kcycles(uint64 c) {
+    return c >> 10;
+}
+
+int main(int argc, char* argv[]) {
+    struct lockinfo *li, t;
+    int i, j, n;
+
+    if(argc > 1) {
+        if(strcmp(argv[1], "on") == 0)
+            lockstat(LOCKSTAT_ON, 0, 0);
+        else if(strcmp(argv[1], "off") == 0)
+            lockstat(LOCKSTAT_OFF, 0, 0);
+        else if(strcmp(argv[1], "reset") == 0)
+            lockstat(LOCKSTAT_RESET, 0, 0);
+        else
+            printf(2, "usage: lockstat [on | off | reset]\n");
+        exit();
+    }
+
+    if((n = lockstat(LOCKSTAT_READ, info, NINFO)) < 0) {
+        printf(2, "lockstat: failed\n");
+        exit();
+    }
+
+    // Worst offenders first: most time spent waiting.
+    for(i = 1; i < n; i++) {
+        t = info[i];
+        for(j = i; j > 0 && info[j-1].wait < t.wait; j--)
+            info[j] = info[j-1];
+        info[j] = t;
+    }
+
+    printf(1, "times in units of 1024 cycles\n");
+    printf(1, "name\t\tlocks\tacquire\tcontend\twait\tmaxwait\thold\tmaxhold\n");
+    for(i = 0; i < n && i < NTOP; i++) {
+        li = &info[i];
+        if(li->acquire == 0)
+            break;
+        printf(1, "%s%s%s\t%d\t%d\t%d\t%d\t%d\t%d\t%d\n",
+               li->sleep ? "*" : "", li->name, strlen(li->name) + li->sleep < 8 ? "\t" : "",
+               li->nlocks, li->acquire, li->contended,
+               kcycles(li->wait), kcycles(li->maxwait),
+               kcycles(li->hold), kcycles(li->maxhold));
+    }
+    printf(1, "(* = sleep lock)\n");
+
+    printf(1, "\nsleep lock spinning\nname\t\tspins\tsucceeded\n");
+    for(i = 0; i < n; i++) {
+        li = &info[i];
+        if(!li->sleep || li->spin == 0)
+            continue;
+        printf(1, "%s%s\t%d\t%d%%\n", li->name, strlen(li->name) < 8 ? "\t" : "",
+               li->spin, li->spinok * 100 / li->spin);
+    }
+    exit();
+}
@@ -0,0 +1,24 @@
+// Lock contention statistics.
+// Both the kernel and user programs use this header file.
+
+// lockstat() commands
+#define LOCKSTAT_READ   0   // Copy out statistics
+#define LOCKSTAT_ON     1   // Start collecting
+#define LOCKSTAT_OFF    2   // Stop collecting
+#define LOCKSTAT_RESET  3   // Clear statistics
+
+// Statistics for all locks initialized with one name,
+// as returned by lockstat().  Times are in TSC cycles.
+struct lockinfo {
+  char name[16];
+  int sleep;         // 1 for sleep locks, 0 for spin locks
+  int nlocks;        // Locks initialized with this name
+  uint acquire;      // Acquisitions
+  uint contended;    // Acquisitions that had to wait
+  uint64 wait;       // Total time spent waiting
+  uint64 maxwait;
+  uint64 hold;       // Total time held
+  uint64 maxhold;
+  uint spin;         // Sleep lock waits that spun on a running owner
+  uint spinok;       // ... and found the lock free afterwards
+};
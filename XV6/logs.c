@@ -1,15 +1,159 @@
+// logs [-u uid] [-c syscall] [-f from] [-t to] [-n lines]
+//
+// Prints the audit log that auditd keeps, oldest first, a page
+// of lines at a time.  Times are given as YYYYMMDDhhmmss or any
+// prefix of it: -f fills the missing fields with their lowest
+// values and -t with their highest, so "-f 2024 -t 2024" is the
+// whole year.  Without a log on disk, prints the kernel's
+// in-memory trace instead.
+
 #include "types.h"
+#include "param.h"
+#include "date.h"
+#include "fcntl.h"
+#include "syscall.h"
 #include "user.h"
+#include "trace.h"
+#include "sysnames.h"
+
+#define WRONG_INPUT "Usage: logs [-u uid] [-c syscall] [-f from] [-t to] [-n lines]"
+
+#define NREC 64
+#define NSYSNAMES (sizeof(sysnames)/sizeof(sysnames[0]))
+
+static int uid = -1, num = -1, page = 20, shown;
+static uint from, to = 0xffffffff;
+
+// Parse a YYYYMMDDhhmmss prefix into an AUDITTIME, filling the
+// missing fields from dflt.
+static int parsetime(char *s, struct rtcdate *dflt, uint *t) {
+    static int width[] = { 4, 2, 2, 2, 2, 2 };
+    uint *field[6];
+    struct rtcdate r = *dflt;
+    int i, j, v;
+
+    field[0] = &r.year; field[1] = &r.month; field[2] = &r.day;
+    field[3] = &r.hour; field[4] = &r.minute; field[5] = &r.second;
+    for(i = 0; i < 6 && *s; i++) {
+        for(v = 0, j = 0; j < width[i]; j++, s++) {
+            if(*s < '0' || *s > '9')
+                return -1;
+            v = v * 10 + *s - '0';
+        }
+        *field[i] = v;
+    }
+    if(*s || r.year < 2000)
+        return -1;
+    *t = AUDITTIME(&r);
+    return 0;
+}
+
+static int sysnum(char *name) {
+    int i;
+
+    for(i = 1; i < NSYSNAMES; i++)
+        if(sysnames[i] && strcmp(sysnames[i], name) == 0)
+            return i;
+    return -1;
+}
 
-#define WRONG_INPUT "Usage: logs"
+static void put2(uint v) {
+    printf(1, "%d%d", v / 10 % 10, v % 10);
+}
+
+// Wait for the user after each page; return 0 to stop.
+static int more(void) {
+    char c;
+
+    if(++shown % page)
+        return 1;
+    printf(1, "-- more (q to quit) --");
+    fflush(1);
+    while(read(0, &c, 1) == 1 && c != '\n')
+        if(c == 'q')
+            return 0;
+    return 1;
+}
+
+static int show(struct auditrec *a) {
+    uint t = a->time;
+
+    if(a->num != AUDIT_LOST) {
+        if((uid >= 0 && a->uid != uid) || (num >= 0 && a->num != num))
+            return 1;
+    } else if(uid >= 0 || num >= 0)
+        return 1;
+    if(t < from || t > to)
+        return 1;
+    printf(1, "%d", 2000 + (t >> 26));
+    put2(t >> 22 & 0xf);
+    put2(t >> 17 & 0x1f);
+    printf(1, " ");
+    put2(t >> 12 & 0x1f);
+    printf(1, ":");
+    put2(t >> 6 & 0x3f);
+    printf(1, ":");
+    put2(t & 0x3f);
+    if(a->num == AUDIT_LOST)
+        printf(1, "  %d records lost\n", a->ret);
+    else if(a->num < NSYSNAMES && sysnames[a->num])
+        printf(1, "  uid %d pid %d %s = %d\n", a->uid, a->pid, sysnames[a->num], a->ret);
+    else
+        printf(1, "  uid %d pid %d syscall %d = %d\n", a->uid, a->pid, a->num, a->ret);
+    return more();
+}
+
+// Show the records of one log file; return -1 if it cannot be
+// opened, 0 if the user quit, 1 otherwise.
+static int showfile(char *path) {
+    static struct auditrec recs[NREC];
+    int fd, i, n;
+
+    if((fd = open(path, O_RDONLY)) < 0)
+        return -1;
+    while((n = read(fd, recs, sizeof(recs))) > 0)
+        for(i = 0; i < n / sizeof(recs[0]); i++)
+            if(!show(&recs[i])) {
+                close(fd);
+                return 0;
+            }
+    close(fd);
+    return 1;
+}
 
 int main(int argc, char* argv[]) {
-    if(argc != 1) {
+    struct rtcdate lo = { 0, 0, 0, 1, 1, 2000 };
+    struct rtcdate hi = { 59, 59, 23, 31, 12, 2063 };
+    int i, r;
+
+    for(i = 1; i + 1 < argc && argv[i][0] == '-'; i += 2) {
+        if(strcmp(argv[i], "-u") == 0)
+            uid = atoi(argv[i + 1]);
+        else if(strcmp(argv[i], "-c") == 0) {
+            if((num = sysnum(argv[i + 1])) < 0) {
+                printf(2, "logs: unknown system call %s\n", argv[i + 1]);
+                exit();
+            }
+        } else if(strcmp(argv[i], "-f") == 0) {
+            if(parsetime(argv[i + 1], &lo, &from) < 0)
+                break;
+        } else if(strcmp(argv[i], "-t") == 0) {
+            if(parsetime(argv[i + 1], &hi, &to) < 0)
+                break;
+        } else if(strcmp(argv[i], "-n") == 0)
+            page = atoi(argv[i + 1]);
+        else
+            break;
+    }
+    if(i != argc) {
         printf(1, "%s\n", WRONG_INPUT);
         exit();
     }
+    if(page < 1)
+        page = 1;
 
-    logs();
-
+    r = showfile(AUDITOLD);
+    if(r != 0 && showfile(AUDITLOG) < 0 && r < 0)
+        logs();
     exit();
-}
\ No newline at end of file
+}
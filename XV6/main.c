@@ -5,6 +5,7 @@
 #include "mmu.h"
 #include "proc.h"
 #include "x86.h"
+#include "user_mgmt.h"
 
 static void startothers(void);
 static void mpmain(void)  __attribute__((noreturn));
@@ -27,8 +28,12 @@ main(void)
   consoleinit();   // console hardware
   uartinit();      // serial port
   pinit();         // process table
+  traceinit();     // system call tracing
+  profinit();      // sampling profiler
+  init_users();    // user table
   tvinit();        // trap vectors
   binit();         // buffer cache
+  iinit();         // inode cache
   fileinit();      // file table
   ideinit();       // disk 
   startothers();   // start other processors
@@ -4,6 +4,7 @@
 #include <string.h>
 #include <fcntl.h>
 #include <assert.h>
+#include <time.h>
 
 #define stat xv6_stat  // avoid clash with host struct stat
 #include "types.h"
@@ -40,6 +41,7 @@ void rinode(uint inum, struct dinode *ip);
 void rsect(uint sec, void *buf);
 uint ialloc(ushort type);
 void iappend(uint inum, void *p, int n);
+void dirappend(uint dino, char *name, uint inum);
 
 // convert to intel byte order
 ushort
@@ -69,7 +71,6 @@ main(int argc, char *argv[])
 {
   int i, cc, fd;
   uint rootino, inum, off;
-  struct dirent de;
   char buf[BSIZE];
   struct dinode din;
 
@@ -117,15 +118,15 @@ main(int argc, char *argv[])
   rootino = ialloc(T_DIR);
   assert(rootino == ROOTINO);
 
-  bzero(&de, sizeof(de));
-  de.inum = xshort(rootino);
-  strcpy(de.name, ".");
-  iappend(rootino, &de, sizeof(de));
+  // The root is a hashed directory; lay out its empty bucket blocks.
+  rinode(rootino, &din);
+  din.flags = xint(I_HASHDIR);
+  winode(rootino, &din);
+  for(i = 0; i < DIRHASH_NBUCKET; i++)
+    iappend(rootino, zeroes, BSIZE);
 
-  bzero(&de, sizeof(de));
-  de.inum = xshort(rootino);
-  strcpy(de.name, "..");
-  iappend(rootino, &de, sizeof(de));
+  dirappend(rootino, ".", rootino);
+  dirappend(rootino, "..", rootino);
 
   for(i = 2; i < argc; i++){
     assert(index(argv[i], '/') == 0);
@@ -143,11 +144,7 @@ main(int argc, char *argv[])
       ++argv[i];
 
     inum = ialloc(T_FILE);
-
-    bzero(&de, sizeof(de));
-    de.inum = xshort(inum);
-    strncpy(de.name, argv[i], DIRSIZ);
-    iappend(rootino, &de, sizeof(de));
+    dirappend(rootino, argv[i], inum);
 
     while((cc = read(fd, buf, sizeof(buf))) > 0)
       iappend(inum, buf, cc);
@@ -158,9 +155,11 @@ main(int argc, char *argv[])
   // fix size of root inode dir
   rinode(rootino, &din);
   off = xint(din.size);
-  off = ((off/BSIZE) + 1) * BSIZE;
-  din.size = xint(off);
-  winode(rootino, &din);
+  if(off % BSIZE){
+    off = ((off/BSIZE) + 1) * BSIZE;
+    din.size = xint(off);
+    winode(rootino, &din);
+  }
 
   balloc(freeblock);
 
@@ -230,6 +229,8 @@ ialloc(ushort type)
   din.type = xshort(type);
   din.nlink = xshort(1);
   din.size = xint(0);
+  // Seconds since 2000-01-01, as the kernel's epochtime().
+  din.mtime = din.ctime = xint(time(0) - 946684800);
   winode(inum, &din);
   return inum;
 }
@@ -295,3 +296,62 @@ iappend(uint inum, void *xp, int n)
   din.size = xint(off);
   winode(inum, &din);
 }
+
+// Sector holding block fbn of an inode that already has it.
+uint
+bnum(struct dinode *din, uint fbn)
+{
+  uint indirect[NINDIRECT];
+
+  if(fbn < NDIRECT)
+    return xint(din->addrs[fbn]);
+  rsect(xint(din->addrs[NDIRECT]), (char*)indirect);
+  return xint(indirect[fbn - NDIRECT]);
+}
+
+// Same hash as dirhash() in fs.c.
+uint
+dirhash(char *name)
+{
+  uint h;
+  int i;
+
+  h = 2166136261;
+  for(i = 0; i < DIRSIZ && name[i]; i++){
+    h ^= (uchar)name[i];
+    h *= 16777619;
+  }
+  return h;
+}
+
+// Add (name, inum) to directory dino, placing it in its
+// hash bucket if dino is a hashed directory.
+void
+dirappend(uint dino, char *name, uint inum)
+{
+  struct dinode din;
+  struct dirent de, *dp;
+  char buf[BSIZE];
+  uint i, b, sec;
+
+  bzero(&de, sizeof(de));
+  de.inum = xshort(inum);
+  strncpy(de.name, name, DIRSIZ);
+
+  rinode(dino, &din);
+  if(xint(din.flags) & I_HASHDIR){
+    b = dirhash(de.name) % DIRHASH_NBUCKET;
+    for(i = 0; i < DIRHASH_NBUCKET; i++, b = (b + 1) % DIRHASH_NBUCKET){
+      sec = bnum(&din, b);
+      rsect(sec, buf);
+      for(dp = (struct dirent*)buf; dp < (struct dirent*)buf + DPB; dp++){
+        if(dp->inum == 0){
+          *dp = de;
+          wsect(sec, buf);
+          return;
+        }
+      }
+    }
+  }
+  iappend(dino, &de, sizeof(de));
+}
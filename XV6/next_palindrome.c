@@ -1,27 +1,29 @@
 #include "types.h"
 #include "user.h"
-#define WRONGINPUTTRYAGAIN "invalid command!try again"
-int main(int argc,char *argv[])
+
+// Prints the smallest palindrome not less than each argument.
+// Numbers are decimal strings of any length.
+int main(int argc, char *argv[])
 {
-    if(argc!=2)
-    {
-        printf(1,"%s\n",WRONGINPUTTRYAGAIN);
+    char *buf;
+    int i, n;
+
+    if(argc < 2) {
+        printf(2, "usage: next_palindrome number ...\n");
         exit();
     }
-    int num=atoi(argv[1]),prev_val_ebx;
-    asm volatile(
-        "movl %%ebx, %0\n\t"
-        "movl %1, %%ebx"
-        :"=r" (prev_val_ebx)
-        :"r" (num)
-        :"ebx" 
-    );
-    next_palindrome(num);
-    asm volatile(
-        "movl %0, %%ebx"
-        :
-        :"r" (prev_val_ebx)
-        :"ebx" 
-    );
+    for(i = 1; i < argc; i++) {
+        // As many digits as the input, and a NUL.
+        n = strlen(argv[i]) + 1;
+        if((buf = malloc(n)) == 0) {
+            printf(2, "next_palindrome: out of memory\n");
+            exit();
+        }
+        if(next_palindrome(argv[i], buf, n) < 0)
+            printf(2, "next_palindrome: %s is not a number\n", argv[i]);
+        else
+            printf(1, "%s\n", buf);
+        free(buf);
+    }
     exit();
-}
\ No newline at end of file
+}
@@ -3,12 +3,18 @@
 #define NCPU          8  // maximum number of CPUs
 #define NOFILE       16  // open files per process
 #define NFILE       100  // open files per system
-#define NINODE       50  // maximum number of active i-nodes
+#define NINODE      200  // size of in-memory inode cache
+#define NDENTRY     128  // size of directory entry cache
 #define NDEV         10  // maximum major device number
 #define ROOTDEV       1  // device number of file system root disk
 #define MAXARG       32  // max exec arguments
 #define MAXOPBLOCKS  10  // max # of blocks any FS op writes
 #define LOGSIZE      (MAXOPBLOCKS*3)  // max data blocks in on-disk log
 #define NBUF         (MAXOPBLOCKS*3)  // size of disk block cache
-#define FSSIZE       2000  // size of file system in blocks
+#define FSSIZE       4000  // size of file system in blocks
+#define NSYSCALL     64  // system call numbers are below this
+#define NTRACE      256  // records in each CPU's syscall trace ring
+#define NPROF      1024  // samples in each CPU's profiling ring
+#define NLOCKCLASS   64  // distinct lock names with statistics
+#define SLEEPSPIN 20000  // max cycles acquiresleep spins on a running owner
 
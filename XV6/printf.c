@@ -2,10 +2,106 @@
 #include "stat.h"
 #include "user.h"
 
+// Output to fds below NSTREAM is buffered, BUFSIZE bytes at a
+// time: line buffered if the fd is a device (the console) and
+// fully buffered otherwise, unless changed with setvbuf.
+// ulib.c calls stdiohook to flush before write, read, close,
+// fork, exec and exit.
+#define NSTREAM 8
+#define BUFSIZE 512
+
+struct stream {
+  int mode;   // 0 until first use, then _IONBF, _IOLBF or _IOFBF
+  int n;      // Bytes in buf
+  char *buf;
+};
+
+static struct stream streams[NSTREAM];
+
+extern void (*stdiohook)(int, int);
+int _write(int, const void*, int);
+
+static void
+flush(struct stream *s, int fd)
+{
+  if(s->n > 0)
+    _write(fd, s->buf, s->n);
+  s->n = 0;
+}
+
+void
+fflush(int fd)
+{
+  int i;
+
+  if(fd >= 0 && fd < NSTREAM){
+    flush(&streams[fd], fd);
+    return;
+  }
+  if(fd == -1)
+    for(i = 0; i < NSTREAM; i++)
+      flush(&streams[i], i);
+}
+
+static void
+hook(int fd, int closing)
+{
+  fflush(fd);
+  if(closing && fd >= 0 && fd < NSTREAM)
+    streams[fd].mode = 0;
+}
+
+// Set up fd's stream on first use.
+static struct stream*
+stream(int fd)
+{
+  struct stream *s;
+  struct stat st;
+
+  if(fd < 0 || fd >= NSTREAM)
+    return 0;
+  s = &streams[fd];
+  if(s->mode == 0){
+    stdiohook = hook;
+    if(fstat(fd, &st) == 0 && st.type == T_DEV)
+      s->mode = _IOLBF;
+    else
+      s->mode = _IOFBF;
+  }
+  if(s->mode != _IONBF && s->buf == 0 && (s->buf = malloc(BUFSIZE)) == 0)
+    s->mode = _IONBF;
+  return s;
+}
+
+// Set fd's buffering mode, flushing what is buffered.
+int
+setvbuf(int fd, int mode)
+{
+  struct stream *s;
+
+  if(mode != _IONBF && mode != _IOLBF && mode != _IOFBF)
+    return -1;
+  if((s = stream(fd)) == 0)
+    return -1;
+  flush(s, fd);
+  s->mode = mode;
+  if(stream(fd)->mode != mode)
+    return -1;
+  return 0;
+}
+
 static void
 putc(int fd, char c)
 {
-  write(fd, &c, 1);
+  struct stream *s;
+
+  if((s = stream(fd)) == 0 || s->mode == _IONBF){
+    _write(fd, &c, 1);
+    return;
+  }
+  s->buf[s->n++] = c;
+  if(s->n == BUFSIZE || (c == '\n' && s->mode == _IOLBF))
+    flush(s, fd);
 }
 
 static void
@@ -6,6 +6,7 @@
 #include "x86.h"
 #include "proc.h"
 #include "spinlock.h"
+#include "rwlock.h"
 
 #include "user_mgmt.h" 
 
@@ -48,25 +49,11 @@ int number_of_all_customer = 0;
 
 
 
-typedef struct reader_writer
-{
-  struct spinlock critical_section;
-  struct spinlock is_writer_waiting;
-  struct spinlock waiting_reader;
+// State for the reader_writer demo (critical_section()).
+struct {
+  struct rwlock lock;
   int counter;
-  int active_reader_count;
-  int active_writer_count;
-  int number_of_waiting_writer;
-  int number_of_waiting_reader;
-  int waiting_writer_head;
-  int waiting_writer_tail;
-  int waiting_writer_pid[64];
-  int waiting_reader_head;
-  int waiting_reader_tail;
-  int waiting_reader_pid[64];
-  int number_of_woke_up_reader;
-} reader_writer;
-reader_writer rw;
+} rw;
 int sequence[100];
 int number_of_processes_in_sequence = 0;
 struct spinlock sequence_process_lock;
@@ -89,12 +76,20 @@ const char *scheduling_algorithms[] = {
   [MULTILEVEL_FEEDBACK_QUEUE_SECOND_LEVEL] = "mlfq(FCFS)"
 };
 
-extern struct user *curr_user;
-extern struct spinlock login_lock;
 
+#define NPIDHASH 64
+#define PTREADTRIES 8  // lockless ptable reads before taking the lock
+
+// seq is a seqlock over everything ptable.lock protects: it is
+// odd while a holder of the lock may be changing ptable, and
+// changes every time that happens (see ptacquire).  Read-mostly
+// code can copy state out of ptable without the lock and retry
+// if seq changed meanwhile.
 struct {
   struct spinlock lock;
+  volatile uint seq;
   struct proc proc[NPROC];
+  struct proc *pidhash[NPIDHASH];  // Chained through proc.pidnext
 } ptable;
 
 static struct proc *initproc;
@@ -105,11 +100,100 @@ extern void trapret(void);
 
 static void wakeup1(void *chan);
 
+// Take ptable.lock to change ptable.  All code in this file
+// takes and releases it through ptacquire and ptrelease, to keep
+// ptable.seq up to date, except for the scheduler's idle passes.
+static void
+ptacquire(void)
+{
+  acquire(&ptable.lock);
+  ptable.seq++;
+  __sync_synchronize();
+}
+
+// Turn a lock taken with acquire(&ptable.lock), which leaves
+// seq alone, into one taken with ptacquire.
+static void
+ptwrite(void)
+{
+  ptable.seq++;
+  __sync_synchronize();
+}
+
+static void
+ptrelease(void)
+{
+  __sync_synchronize();
+  ptable.seq++;
+  release(&ptable.lock);
+}
+
+// Start a lockless read of ptable.  Returns the sequence
+// number to pass to ptreadok, which will fail if it is odd.
+static uint
+ptreadbegin(void)
+{
+  uint seq;
+
+  seq = ptable.seq;
+  __sync_synchronize();
+  return seq;
+}
+
+// Did the read started by ptreadbegin see no writers?
+static int
+ptreadok(uint seq)
+{
+  __sync_synchronize();
+  return (seq & 1) == 0 && ptable.seq == seq;
+}
+
+static void
+pidinsert(struct proc *p)
+{
+  struct proc **h = &ptable.pidhash[p->pid % NPIDHASH];
+
+  p->pidnext = *h;
+  *h = p;
+}
+
+static void
+pidremove(struct proc *p)
+{
+  struct proc **pp;
+
+  for(pp = &ptable.pidhash[p->pid % NPIDHASH]; *pp; pp = &(*pp)->pidnext){
+    if(*pp == p){
+      *pp = p->pidnext;
+      break;
+    }
+  }
+  p->pidnext = 0;
+}
+
+// Look pid up in the hash.  The caller either holds ptable.lock
+// or will check ptreadok: chains only link ptable entries, and
+// the walk is bounded in case a concurrent update made a cycle.
+static struct proc*
+pidlookup(int pid)
+{
+  struct proc *p;
+  int n;
+
+  if(pid <= 0)
+    return 0;
+  p = ptable.pidhash[pid % NPIDHASH];
+  for(n = 0; p != 0 && n < NPROC; n++, p = p->pidnext)
+    if(p->pid == pid && p->state != UNUSED)
+      return p;
+  return 0;
+}
+
 void
 pinit(void)
 {
   initlock(&print_lock , "print");
-  initlock(&ptable.lock, "ptable");
+  initticketlock(&ptable.lock, "ptable");
   initlock(&barber.barber_is_working, "barber_is_working");
   initlock(&customer.modify_customer_queue, "modify_customer_queue");
   for (int i = 0; i < 5; i++)
@@ -174,27 +258,33 @@ allocproc(void)
   struct proc *p;
   char *sp;
 
-  acquire(&ptable.lock);
+  ptacquire();
 
   for(p = ptable.proc; p < &ptable.proc[NPROC]; p++)
     if(p->state == UNUSED)
       goto found;
 
-  release(&ptable.lock);
+  ptrelease();
   return 0;
 
 found:
   p->state = EMBRYO;
   p->pid = nextpid++;
+  pidinsert(p);
   p->waiting_time=0; //additional
   p->arrival_time_to_system=ticks; //additional
   p->continous_time_to_run=0; //additional
+  memset(p->tracemask, 0, sizeof(p->tracemask));
+  p->session = 0;
 
-  release(&ptable.lock);
+  ptrelease();
 
   // Allocate kernel stack.
   if((p->kstack = kalloc()) == 0){
+    ptacquire();
+    pidremove(p);
     p->state = UNUSED;
+    ptrelease();
     return 0;
   }
   sp = p->kstack + KSTACKSIZE;
@@ -247,14 +337,14 @@ userinit(void)
   // run this process. the acquire forces the above
   // writes to be visible, and the lock is also needed
   // because the assignment might not be atomic.
-  acquire(&ptable.lock);
+  ptacquire();
 
   p->state = RUNNABLE;
   p->cal=MULTILEVEL_FEEDBACK_QUEUE_FIRST_LEVEL; //additional
   p->arrival_time_to_system=ticks;
   number_of_runnable_multilevel_feedback_queue[0]++; //additional
 
-  release(&ptable.lock);
+  ptrelease();
 }
 
 // Grow current process's memory by n bytes.
@@ -297,7 +387,10 @@ fork(void)
   if((np->pgdir = copyuvm(curproc->pgdir, curproc->sz)) == 0){
     kfree(np->kstack);
     np->kstack = 0;
+    ptacquire();
+    pidremove(np);
     np->state = UNUSED;
+    ptrelease();
     return -1;
   }
   np->sz = curproc->sz;
@@ -313,10 +406,13 @@ fork(void)
   np->cwd = idup(curproc->cwd);
 
   safestrcpy(np->name, curproc->name, sizeof(curproc->name));
+  memmove(np->tracemask, curproc->tracemask, sizeof(curproc->tracemask));
+  np->session = curproc->session;
+  session_dup(np->session);
 
   pid = np->pid;
 
-  acquire(&ptable.lock);
+  ptacquire();
 
   np->state = RUNNABLE;
   if(curproc==initproc || (strlen(np->name)==2 && strncmp(np->name, "sh", 2) == 0)) //additional
@@ -333,7 +429,7 @@ fork(void)
     np->arrival_time_to_system=ticks;
   }
 
-  release(&ptable.lock);
+  ptrelease();
 
   return pid;
 }
@@ -364,15 +460,11 @@ exit(void)
   end_op();
   curproc->cwd = 0;
 
-  // // Logout current user if this process was logged in
-  // acquire(&login_lock);
-  // if ((curr_user->is_logged_in == 1) && (curproc->user_id == curr_user->user_id)) {
-  //   curr_user->is_logged_in = 0;
-  // }
-  // release(&login_lock);
-  // ///////////////////////////////////////////////////////
+  // The last process to leave a session logs it out.
+  session_put(curproc->session);
+  curproc->session = 0;
 
-  acquire(&ptable.lock);
+  ptacquire();
 
   if (curproc->state == RUNNABLE) //additional
   {
@@ -426,7 +518,7 @@ wait(void)
   int havekids, pid;
   struct proc *curproc = myproc();
   
-  acquire(&ptable.lock);
+  ptacquire();
   for(;;){
     // Scan through table looking for exited children.
     havekids = 0;
@@ -440,19 +532,20 @@ wait(void)
         kfree(p->kstack);
         p->kstack = 0;
         freevm(p->pgdir);
+        pidremove(p);
         p->pid = 0;
         p->parent = 0;
         p->name[0] = 0;
         p->killed = 0;
         p->state = UNUSED;
-        release(&ptable.lock);
+        ptrelease();
         return pid;
       }
     }
 
     // No point waiting if we don't have any children.
     if(!havekids || curproc->killed){
-      release(&ptable.lock);
+      ptrelease();
       return -1;
     }
 
@@ -590,7 +683,16 @@ void scheduler(void)
     p=0; //additional
 
     // Loop over process table looking for process to run.
+    // A pass that finds nothing runnable changes nothing, so it
+    // leaves ptable.seq alone and lockless readers undisturbed.
     acquire(&ptable.lock);
+    if(number_of_runnable_processes_in_edf_queue == 0 &&
+       number_of_runnable_multilevel_feedback_queue[0] == 0 &&
+       number_of_runnable_multilevel_feedback_queue[1] == 0){
+      release(&ptable.lock);
+      continue;
+    }
+    ptwrite();
     if(number_of_runnable_processes_in_edf_queue!=0) // additional
     {
       p=earliest_deadline_first_scheduler(); // additional
@@ -602,7 +704,7 @@ void scheduler(void)
     if(p==0 || p->state!=RUNNABLE) // aditional
     {
       c->proc=0;
-      release(&ptable.lock); //additional
+      ptrelease(); //additional
       continue; //additional
     } // additional
 
@@ -646,7 +748,7 @@ void scheduler(void)
     c->proc = 0;
     if(p->cal==MULTILEVEL_FEEDBACK_QUEUE_FIRST_LEVEL)
       c->time_for_roundrobin=0;
-    release(&ptable.lock);
+    ptrelease();
   }
 }
 
@@ -680,7 +782,7 @@ sched(void)
 void
 yield(void)
 {
-  acquire(&ptable.lock);  //DOC: yieldlock
+  ptacquire();  //DOC: yieldlock
   myproc()->state = RUNNABLE;
   if(myproc()->cal==EARLIEST_DEADLINE_FIRST) //additional
     number_of_runnable_processes_in_edf_queue++; //additional
@@ -692,7 +794,7 @@ yield(void)
     myproc()->waiting_time=0;
   }
   sched();
-  release(&ptable.lock);
+  ptrelease();
 }
 
 // A fork child's very first scheduling by scheduler()
@@ -702,14 +804,14 @@ forkret(void)
 {
   static int first = 1;
   // Still holding ptable.lock from scheduler.
-  release(&ptable.lock);
+  ptrelease();
 
   if (first) {
     // Some initialization functions must be run in the context
     // of a regular process (e.g., they call sleep), and thus cannot
     // be run from main().
     first = 0;
-    iinit(ROOTDEV);
+    fsinit(ROOTDEV);
     initlog(ROOTDEV);
   }
 
@@ -736,7 +838,7 @@ sleep(void *chan, struct spinlock *lk)
   // (wakeup runs with ptable.lock locked),
   // so it's okay to release lk.
   if(lk != &ptable.lock){  //DOC: sleeplock0
-    acquire(&ptable.lock);  //DOC: sleeplock1
+    ptacquire();  //DOC: sleeplock1
     release(lk);
   }
   // Go to sleep.
@@ -762,7 +864,7 @@ sleep(void *chan, struct spinlock *lk)
 
   // Reacquire original lock.
   if(lk != &ptable.lock){  //DOC: sleeplock2
-    release(&ptable.lock);
+    ptrelease();
     acquire(lk);
   }
 }
@@ -796,9 +898,9 @@ wakeup1(void *chan)
 void
 wakeup(void *chan)
 {
-  acquire(&ptable.lock);
+  ptacquire();
   wakeup1(chan);
-  release(&ptable.lock);
+  ptrelease();
 }
 
 // Kill the process with the given pid.
@@ -809,18 +911,34 @@ kill(int pid)
 {
   struct proc *p;
 
-  acquire(&ptable.lock);
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-    if(p->pid == pid){
-      p->killed = 1;
-      // Wake process from sleep if necessary.
-      if(p->state == SLEEPING)
-        p->state = RUNNABLE;
-      release(&ptable.lock);
-      return 0;
-    }
+  ptacquire();
+  if((p = pidlookup(pid)) != 0){
+    p->killed = 1;
+    // Wake process from sleep if necessary.
+    if(p->state == SLEEPING)
+      p->state = RUNNABLE;
+    ptrelease();
+    return 0;
   }
-  release(&ptable.lock);
+  ptrelease();
+  return -1;
+}
+
+// Set the system call trace mask of the process with the
+// given pid.  The mask is inherited across fork and exec.
+// Fails once the process has exited.
+int
+settrace(int pid, uint *mask)
+{
+  struct proc *p;
+
+  ptacquire();
+  if((p = pidlookup(pid)) != 0 && p->state != ZOMBIE){
+    memmove(p->tracemask, mask, sizeof(p->tracemask));
+    ptrelease();
+    return 0;
+  }
+  ptrelease();
   return -1;
 }
 
@@ -862,24 +980,48 @@ procdump(void)
 }
 
 
-void
-next_palindrome(int num)
+// Write to buf the smallest palindrome not less than num, a
+// decimal string of any length, in O(digits): mirror the left
+// half onto the right, and if that comes out smaller, add one to
+// the left half (middle digit included) and mirror again.
+// Returns the result's length, or -1 if num is not a number or
+// the result and its NUL do not fit in n bytes.
+int
+next_palindrome(char *num, char *buf, int n)
 {
-  int i=num;
-  while(1)
-  {
-    int number=i,reverse=0;
-    while(number>0)
-    {
-      int digit=number%10;
-      reverse=reverse*10+digit;
-      number/=10;
-    }
-    if(reverse==i)
+  int len, i, mirror;
+
+  while(num[0] == '0' && num[1])
+    num++;
+  for(len = 0; num[len]; len++)
+    if(num[len] < '0' || num[len] > '9')
+      return -1;
+  if(len == 0 || len + 1 > n)
+    return -1;
+
+  // Is the mirror image at least num?  Compare from the middle
+  // out: the first differing digit of the right half decides.
+  mirror = 1;
+  for(i = len / 2; i < len; i++){
+    if(num[len-1-i] != num[i]){
+      mirror = num[len-1-i] > num[i];
       break;
-    i++;
+    }
+  }
+
+  memmove(buf, num, len);
+  if(!mirror){
+    // The left half is not all nines, or its mirror, all nines,
+    // would not be less than num; so the carry stops inside it
+    // and the result has as many digits as num.
+    for(i = (len - 1) / 2; buf[i] == '9'; i--)
+      buf[i] = '0';
+    buf[i]++;
   }
-  cprintf("result: %d\n",i);
+  for(i = 0; i < len / 2; i++)
+    buf[len-1-i] = buf[i];
+  buf[len] = 0;
+  return len;
 }
 
 int
@@ -897,93 +1039,24 @@ logout(){
   return logout_user();
 }
 
-int logs(){
-  get_user_logs();
-  return 0;
-}
-
+// Move the caller into a new session that is not logged in.
 int
-diff(const char *file1, const char *file2)
+setsid(void)
 {
-  struct inode *ip1, *ip2;
-  char line1[128], line2[128];
-  uint offset1 = 0, offset2 = 0;
-  int line_num = 1;
-  int equal = 1;
-
-  ip1 = namei(file1);
-  ip2 = namei(file2);
+  struct proc *curproc = myproc();
+  struct session *s;
 
-  if (ip1 == 0 || ip2 == 0)
-  {
-    cprintf("Error: one of the files does not exist\n");
+  if((s = session_alloc()) == 0)
     return -1;
-  }
-
-  ilock(ip1);
-  ilock(ip2);
-
-  // test
-  // char buf[512];
-  // int bytes_read;
-  // uint offset = 0;
-  // cprintf("File 1: %s\n", file1);
-  // while ((bytes_read = readi(ip1, buf, offset, sizeof(buf))) > 0) {
-  //   offset += bytes_read;
-  //   for (int i = 0; i < bytes_read; i++) {
-  //     cprintf("%c", buf[i]);
-  //   }
-  // }
-  // cprintf("\nFile 2: %s\n", file1);
-  // while ((bytes_read = readi(ip2, buf, offset, sizeof(buf))) > 0) {
-  //   offset += bytes_read;
-  //   for (int i = 0; i < bytes_read; i++) {
-  //     cprintf("%c", buf[i]);
-  //   }
-  // }
-
-  while (1) {
-    int i = 0;
-    char ch;
-
-    memset(line1, 0, sizeof(line1));
-    while (i < sizeof(line1) - 1 && readi(ip1, &ch, offset1, 1) == 1) {
-      offset1++;
-      if (ch == '\n' || ch == '\r')
-        break;
-      line1[i++] = ch;
-    }
-    line1[i] = 0;
-    int len1 = i;
-
-    i = 0;
-    memset(line2, 0, sizeof(line2));
-    while (i < sizeof(line2) - 1 && readi(ip2, &ch, offset2, 1) == 1) {
-      offset2++;
-      if (ch == '\n' || ch == '\r')
-        break;
-      line2[i++] = ch;
-    }
-    line2[i] = 0;
-    int len2 = i;
-
-    if (len1 == 0 && len2 == 0)
-      break;
-
-    if (strncmp(line1, line2, sizeof(line1)) != 0) {
-      cprintf("Line %d:\n  %s: %s\n  %s: %s\n", line_num, file1, line1, file2, line2);
-      equal = 0;
-    }
-
-    line_num++;
-  }
-
-  iunlockput(ip1);
-  iunlockput(ip2);
-
-  return equal ? 0 : -1;
+  session_put(curproc->session);
+  curproc->session = s;
+  return 0;
 }
 
+int logs(){
+  get_user_logs();
+  return 0;
+}
 
 int
 set_sleep_syscall(int input_tick)
@@ -1012,7 +1085,7 @@ set_sleep_syscall(int input_tick)
 void
 aging_mechanism() //additional
 {
-  acquire(&ptable.lock);
+  ptacquire();
   for(struct proc* p=&ptable.proc[0];p<&ptable.proc[NPROC];p++)
   {
     if(p->state==RUNNABLE && p->cal==MULTILEVEL_FEEDBACK_QUEUE_SECOND_LEVEL)
@@ -1035,7 +1108,7 @@ aging_mechanism() //additional
   //   if (p && p->state == RUNNING)
   //     p->continous_time_to_run++;
   // }
-  release(&ptable.lock);
+  ptrelease();
 }
 
 
@@ -1045,7 +1118,7 @@ create_realtime_process(int decided_deadline)
 {
   struct proc* p = myproc();
 
-  acquire(&ptable.lock);
+  ptacquire();
 
   if (p->state == RUNNABLE) {
     if (p->cal == MULTILEVEL_FEEDBACK_QUEUE_FIRST_LEVEL)
@@ -1070,21 +1143,35 @@ create_realtime_process(int decided_deadline)
   if (p->state == RUNNABLE)
     number_of_runnable_processes_in_edf_queue++;
 
-  release(&ptable.lock);
+  ptrelease();
   return 0;
 }
 
 
 
+// Find the process with the given pid, with or without
+// ptable.lock held.  Without it, the process may exit
+// as soon as this returns.
 struct proc*
 get_proc_by_pid(int pid)
 {
   struct proc *p;
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++) {
-    if(p->pid == pid && p->state != UNUSED)
+  uint seq;
+  int tries;
+
+  if(holding(&ptable.lock))
+    return pidlookup(pid);
+  for(tries = 0; tries < PTREADTRIES; tries++){
+    seq = ptreadbegin();
+    p = pidlookup(pid);
+    if(ptreadok(seq))
       return p;
+    pause();
   }
-  return 0;
+  ptacquire();
+  p = pidlookup(pid);
+  ptrelease();
+  return p;
 }
 
 
@@ -1095,11 +1182,11 @@ change_process_queue(int pid, int new_queue_type)
   int result = 0;
   int saved_ticks = 0;
 
-  acquire(&ptable.lock);
+  ptacquire();
 
   if (new_queue_type != MULTILEVEL_FEEDBACK_QUEUE_FIRST_LEVEL &&
   new_queue_type != MULTILEVEL_FEEDBACK_QUEUE_SECOND_LEVEL) {
-    release(&ptable.lock);
+    ptrelease();
     cprintf("Error: invalid queue type\n");
     return -1;
   }
@@ -1107,19 +1194,19 @@ change_process_queue(int pid, int new_queue_type)
   p = get_proc_by_pid(pid);
   cprintf("pid\t%d\t%d\t%d\n",p->pid,p->continous_time_to_run,ticks);
   if (p == 0) {
-    release(&ptable.lock);
+    ptrelease();
     cprintf("Error: no process found with pid %d\n", pid);
     return -1;
   }
 
   if (p->cal == new_queue_type) {
-    release(&ptable.lock);
+    ptrelease();
     cprintf("Error: process %d is already in the specified queue\n", pid);
     return -1;
   }
 
   if (p->state == RUNNING && p != myproc()) {
-    release(&ptable.lock);
+    ptrelease();
     cprintf("Error: Cannot move RUNNING process from another CPU\n");
     return -1;
   }
@@ -1152,7 +1239,7 @@ change_process_queue(int pid, int new_queue_type)
   p->arrival_time_to_system=saved_ticks;
 
   p->waiting_time = 0;
-  release(&ptable.lock);
+  ptrelease();
   
   return 0;
 }
@@ -1173,12 +1260,11 @@ int num_digits(int n) {
   return count;
 }
 
-int
-collect_process_snapshots(struct proc_snapshot *list, int max_count)
+static int
+copy_process_snapshots(struct proc_snapshot *list, int max_count)
 {
   int count = 0;
 
-  acquire(&ptable.lock);
   for (struct proc *p = ptable.proc; p < &ptable.proc[NPROC]; p++) {
     if (p->state != UNUSED && count < max_count) {
       safestrcpy(list[count].name, p->name, sizeof(p->name));
@@ -1193,8 +1279,27 @@ collect_process_snapshots(struct proc_snapshot *list, int max_count)
       count++;
     }
   }
-  release(&ptable.lock);
+  return count;
+}
 
+// Copy out the live processes, preferably without
+// holding up the scheduler by taking ptable.lock.
+int
+collect_process_snapshots(struct proc_snapshot *list, int max_count)
+{
+  int count, tries;
+  uint seq;
+
+  for(tries = 0; tries < PTREADTRIES; tries++){
+    seq = ptreadbegin();
+    count = copy_process_snapshots(list, max_count);
+    if(ptreadok(seq))
+      return count;
+    pause();
+  }
+  ptacquire();
+  count = copy_process_snapshots(list, max_count);
+  ptrelease();
   return count;
 }
 
@@ -1359,65 +1464,9 @@ void cut_hair()
 
 void init_rw_lock()
 {
-  initlock(&rw.critical_section, "critical_section");
-  initlock(&rw.is_writer_waiting, "is_writer_waiting");
-  initlock(&rw.waiting_reader, "waiting_reader");
+  initrwlock(&rw.lock, "rw", RW_WRITERS);
   initlock(&sequence_process_lock, "sequence_process_lock");
   rw.counter = 0;
-  rw.active_reader_count = 0;
-  rw.active_writer_count = 0;
-  rw.number_of_waiting_writer = 0;
-  rw.waiting_writer_head = 0;
-  rw.waiting_writer_tail = 0;
-  rw.waiting_reader_head = 0;
-  rw.waiting_reader_tail = 0;
-  rw.number_of_waiting_reader = 0;
-  rw.number_of_woke_up_reader=0;
-  for (int i = 0; i < 64; i++) {
-    rw.waiting_writer_pid[i] = 0;
-    rw.waiting_reader_pid[i] = 0;
-  }
-}
-
-void writer_write_lock()
-{
-  acquire(&rw.is_writer_waiting);
-  if (rw.active_reader_count > 0 || rw.active_writer_count > 0 || rw.number_of_waiting_writer > 0 || rw.number_of_woke_up_reader>0)
-  {
-    rw.waiting_writer_pid[rw.waiting_writer_tail] = myproc()->pid;
-    rw.waiting_writer_tail = (rw.waiting_writer_tail + 1) % 64;
-    rw.number_of_waiting_writer++;
-    cprintf("writer with pid %d is going to sleep\n", myproc()->pid);
-    sleep(myproc(), &rw.is_writer_waiting);
-    rw.number_of_waiting_writer--;
-    cprintf("writer with pid %d is waking up\n", myproc()->pid);
-    release(&rw.is_writer_waiting);
-  }
-  else
-    release(&rw.is_writer_waiting);
-  acquire(&rw.critical_section);
-  rw.active_writer_count = 1;
-}
-
-void reader_read_lock()
-{
-  acquire(&rw.waiting_reader);
-  if (rw.number_of_waiting_writer > 0 || rw.active_writer_count > 0)
-  {
-    cprintf("reader with pid %d is going to sleep\n", myproc()->pid);
-    rw.waiting_reader_pid[rw.waiting_reader_tail] = myproc()->pid;
-    rw.waiting_reader_tail = (rw.waiting_reader_tail + 1) % 64;
-    rw.number_of_waiting_reader++;
-    sleep(myproc(), &rw.waiting_reader);
-    rw.number_of_waiting_reader--;
-    cprintf("reader with pid %d woke up\n", myproc()->pid);
-    release(&rw.waiting_reader);
-  }
-  else
-    release(&rw.waiting_reader);
-  acquire(&rw.critical_section);
-  rw.active_reader_count++;
-  release(&rw.critical_section);
 }
 
 void get_rw_pattern(int pattern) // reader_writer
@@ -1442,71 +1491,6 @@ void reader_critical_section()
   cprintf("reader with pid %d is exiting critical section\n", myproc()->pid);
 }
 
-void reader_release_lock()
-{
-  rw.active_reader_count--;
-  rw.number_of_woke_up_reader=0;
-  if (rw.active_reader_count == 0 && rw.number_of_waiting_writer > 0)
-  {
-    acquire(&rw.is_writer_waiting);
-    if (rw.number_of_waiting_writer > 0)
-    {
-      cprintf("reader with pid %d is waking up writer with pid %d\n", myproc()->pid, rw.waiting_writer_pid[rw.waiting_writer_head]);
-      wakeup(get_proc_by_pid(rw.waiting_writer_pid[rw.waiting_writer_head]));
-      rw.waiting_writer_head = (rw.waiting_writer_head + 1) % 64;
-    }
-    release(&rw.is_writer_waiting);
-  }
-}
-
-void writer_release_lock()
-{
-  
-  
-  if (rw.number_of_waiting_writer > 0)
-  {
-    rw.active_writer_count--;
-    release(&rw.critical_section);
-    acquire(&rw.is_writer_waiting);
-    if (rw.number_of_waiting_writer > 0)
-    {
-      cprintf("writer with pid %d is waking up writer with pid %d\n", myproc()->pid, rw.waiting_writer_pid[rw.waiting_writer_head]);
-      wakeup(get_proc_by_pid(rw.waiting_writer_pid[rw.waiting_writer_head]));
-      rw.waiting_writer_head = (rw.waiting_writer_head + 1) % 64;
-    }
-    release(&rw.is_writer_waiting);
-  }
-  else if (rw.number_of_waiting_reader > 0)
-  {
-    rw.active_writer_count--;
-    release(&rw.critical_section);
-    acquire(&rw.waiting_reader);
-    int number_of_reader_to_wake = rw.number_of_waiting_reader;
-    for (int i = 0; i < number_of_reader_to_wake; i++)
-    {
-      if(rw.number_of_waiting_writer>0)
-        break;
-      int new_reader_pid = rw.waiting_reader_pid[rw.waiting_reader_head];
-      if (new_reader_pid != 0)
-      {
-        cprintf("writer with pid %d is waking up reader with pid %d\n", myproc()->pid, new_reader_pid);
-        rw.number_of_woke_up_reader++;
-        wakeup(get_proc_by_pid(rw.waiting_reader_pid[rw.waiting_reader_head]));
-      }
-      rw.waiting_reader_head = (rw.waiting_reader_head + 1) % 64;
-    }
-    rw.number_of_waiting_reader = 0;
-    release(&rw.waiting_reader);
-  }
-  else
-  {
-    rw.active_writer_count--;
-    release(&rw.critical_section);
-  }
-  
-  
-}
-
 void writer_critical_section()
 {
   cprintf("writer with pid %d is in critical section\n", myproc()->pid);
@@ -1526,15 +1510,15 @@ void critical_section()
   
   if (duty == 0)
   {
-    reader_read_lock();
+    acquireread(&rw.lock);
     reader_critical_section();
-    reader_release_lock();
+    releaseread(&rw.lock);
   }
   else if (duty == 1)
   {
-    writer_write_lock();
+    acquirewrite(&rw.lock);
     writer_critical_section();
-    writer_release_lock();
+    releasewrite(&rw.lock);
   }
 }
 
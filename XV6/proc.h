@@ -57,6 +57,9 @@ struct proc {
   struct file *ofile[NOFILE];  // Open files
   struct inode *cwd;           // Current directory
   char name[16];               // Process name (debugging)
+  uint tracemask[NSYSCALL/32]; // System calls to trace (trace.c)
+  struct session *session;     // Login session, shared with children
+  struct proc *pidnext;        // Next in ptable pid hash chain
   enum class_and_level cal; //additional
   int entering_time_to_the_fcfs_queue; //additional
   int waiting_time; //additional
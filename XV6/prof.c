@@ -0,0 +1,115 @@
+// Sampling profiler.
+//
+// While profiling is on, every period'th timer interrupt on each
+// CPU records the interrupted eip, the running pid and whether
+// it was in user mode.  As in trace.c, each CPU writes only its
+// own ring, with interrupts off, so sampling takes no lock; a
+// reader that is lapped while copying a sample drops it.  When
+// profiling is off the timer interrupt only tests profperiod.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "x86.h"
+#include "proc.h"
+#include "spinlock.h"
+#include "prof.h"
+
+struct profring {
+  struct profsample s[NPROF];
+  volatile uint head;  // Number of samples ever written
+  uint tail;           // Next sample for profread()
+  uint skip;           // Timer interrupts since the last sample
+};
+
+static struct profring rings[NCPU];
+static struct spinlock proflock;
+static volatile uint profperiod;  // 0 when profiling is off
+
+void
+profinit(void)
+{
+  initlock(&proflock, "prof");
+}
+
+// Called on every CPU's timer interrupt.
+void
+proftick(struct trapframe *tf)
+{
+  struct profring *r;
+  struct profsample *s;
+  struct proc *p;
+
+  if(profperiod == 0)
+    return;
+  r = &rings[cpuid()];
+  if(++r->skip < profperiod)
+    return;
+  r->skip = 0;
+
+  p = myproc();
+  s = &r->s[r->head % NPROF];
+  s->eip = tf->eip;
+  s->pid = p ? p->pid : 0;
+  s->user = (tf->cs&3) == DPL_USER;
+  __sync_synchronize();
+  r->head++;
+}
+
+// Start sampling every period timer ticks, discarding
+// any samples not yet read.
+int
+profstart(int period)
+{
+  int c;
+
+  if(period <= 0)
+    return -1;
+  acquire(&proflock);
+  for(c = 0; c < ncpu; c++){
+    rings[c].tail = rings[c].head;
+    rings[c].skip = 0;
+  }
+  profperiod = period;
+  release(&proflock);
+  return 0;
+}
+
+void
+profstop(void)
+{
+  profperiod = 0;
+}
+
+// Move up to n unread samples into buf.  Set *lost to the
+// number of unread samples that were overwritten before we
+// got to them.  Return the number moved.
+int
+profread(struct profsample *buf, int n, uint *lost)
+{
+  struct profring *r;
+  int c, i;
+
+  acquire(&proflock);
+  *lost = 0;
+  i = 0;
+  for(c = 0; c < ncpu && i < n; c++){
+    r = &rings[c];
+    if(r->head - r->tail > NPROF){
+      *lost += r->head - r->tail - NPROF;
+      r->tail = r->head - NPROF;
+    }
+    for(; r->tail != r->head && i < n; r->tail++){
+      buf[i] = r->s[r->tail % NPROF];
+      __sync_synchronize();
+      if(r->head - r->tail >= NPROF)
+        (*lost)++;
+      else
+        i++;
+    }
+  }
+  release(&proflock);
+  return i;
+}
@@ -0,0 +1,9 @@
+// Timer-interrupt PC samples.
+// Both the kernel and user programs use this header file.
+
+// One sample, as returned by profread().
+struct profsample {
+  uint eip;   // Interrupted instruction
+  int pid;    // Running process, or 0 if none
+  int user;   // 1 if eip is a user address
+};
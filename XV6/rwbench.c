@@ -0,0 +1,67 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define MAXPROCS 16
+
+// Indexed by the RW_* policies in rwlock.h.
+static char *policies[] = { "readers", "writers", "phasefair" };
+
+// Run n processes against one policy's lock for nticks ticks.
+void run(int policy, int n, int writepct, int nticks) {
+    int fd[2], counts[2], i, start, reads, writes, min, max;
+
+    if(pipe(fd) < 0) {
+        printf(2, "rwbench: pipe failed\n");
+        exit();
+    }
+    start = uptime() + 2;
+    for(i = 0; i < n; i++) {
+        if(fork() == 0) {
+            close(fd[0]);
+            if(rwbench(policy, writepct, start, start + nticks, counts) < 0)
+                counts[0] = counts[1] = 0;
+            write(fd[1], counts, sizeof(counts));
+            exit();
+        }
+    }
+    close(fd[1]);
+
+    reads = writes = 0;
+    min = max = -1;
+    for(i = 0; i < n && read(fd[0], counts, sizeof(counts)) == sizeof(counts); i++) {
+        reads += counts[0];
+        writes += counts[1];
+        if(min < 0 || counts[0] + counts[1] < min)
+            min = counts[0] + counts[1];
+        if(counts[0] + counts[1] > max)
+            max = counts[0] + counts[1];
+    }
+    close(fd[0]);
+    for(i = 0; i < n; i++)
+        wait();
+
+    printf(1, "%s\t%s%d\t%d\t%d\t%d%%\n", policies[policy],
+           strlen(policies[policy]) < 8 ? "\t" : "", n,
+           reads / nticks, writes / nticks, max > 0 ? min * 100 / max : 0);
+}
+
+int main(int argc, char* argv[]) {
+    int policy, nprocs, writepct, nticks;
+
+    nprocs = argc > 1 ? atoi(argv[1]) : 4;
+    writepct = argc > 2 ? atoi(argv[2]) : 10;
+    nticks = argc > 3 ? atoi(argv[3]) : 100;
+    if(nprocs < 1 || nprocs > MAXPROCS || writepct < 0 || writepct > 100 || nticks < 1) {
+        printf(2, "usage: rwbench [procs] [write%%] [ticks]\n");
+        exit();
+    }
+
+    // reads and writes are per tick, by all processes; fairness
+    // is the slowest process's operations as a share of the fastest's.
+    printf(1, "%d procs, %d%% writes\n", nprocs, writepct);
+    printf(1, "policy\t\tprocs\treads\twrites\tfairness\n");
+    for(policy = 0; policy < 3; policy++)
+        run(policy, nprocs, writepct, nticks);
+    exit();
+}
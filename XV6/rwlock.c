@@ -0,0 +1,143 @@
+// Reader-writer sleeping locks.
+//
+// Waiting readers sleep on &lk->rwait and waiting writers on
+// &lk->wwait, so one wakeup() releases every waiting reader at
+// once.  Readers are admitted in a batch by whoever wakes them:
+// the waker counts them in lk->readers and bumps lk->phase, so
+// a writer cannot slip in between the wakeup and the readers
+// getting to run.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "x86.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "proc.h"
+#include "spinlock.h"
+#include "rwlock.h"
+
+void
+initrwlock(struct rwlock *lk, char *name, int policy)
+{
+  initlock(&lk->lk, "rwlock");
+  lk->name = name;
+  lk->policy = policy;
+  lk->readers = 0;
+  lk->writer = 0;
+  lk->rwait = 0;
+  lk->wwait = 0;
+  lk->phase = 0;
+}
+
+// Admit every waiting reader.  Caller must hold lk->lk.
+static void
+admitreaders(struct rwlock *lk)
+{
+  lk->readers += lk->rwait;
+  lk->rwait = 0;
+  lk->phase++;
+  wakeup(&lk->rwait);
+}
+
+void
+acquireread(struct rwlock *lk)
+{
+  uint phase;
+
+  acquire(&lk->lk);
+  if(!lk->writer && (lk->policy == RW_READERS || lk->wwait == 0)){
+    lk->readers++;
+    release(&lk->lk);
+    return;
+  }
+  // Wait to be admitted; admitreaders() counts us in readers.
+  phase = lk->phase;
+  lk->rwait++;
+  while(lk->phase == phase)
+    sleep(&lk->rwait, &lk->lk);
+  release(&lk->lk);
+}
+
+void
+releaseread(struct rwlock *lk)
+{
+  acquire(&lk->lk);
+  if(--lk->readers == 0 && lk->wwait > 0)
+    wakeup(&lk->wwait);
+  release(&lk->lk);
+}
+
+void
+acquirewrite(struct rwlock *lk)
+{
+  acquire(&lk->lk);
+  lk->wwait++;
+  while(lk->writer || lk->readers > 0)
+    sleep(&lk->wwait, &lk->lk);
+  lk->wwait--;
+  lk->writer = 1;
+  release(&lk->lk);
+}
+
+void
+releasewrite(struct rwlock *lk)
+{
+  acquire(&lk->lk);
+  lk->writer = 0;
+  if(lk->rwait > 0 && (lk->policy != RW_WRITERS || lk->wwait == 0))
+    admitreaders(lk);
+  else if(lk->wwait > 0)
+    wakeup(&lk->wwait);
+  release(&lk->lk);
+}
+
+// For the rwbench system call: one lock per policy.
+static struct rwlock benchrw[3] = {
+  { .policy = RW_READERS, .name = "bench.readers" },
+  { .policy = RW_WRITERS, .name = "bench.writers" },
+  { .policy = RW_PHASEFAIR, .name = "bench.phasefair" },
+};
+static uint benchval;
+
+// Between ticks start and end, repeatedly take the policy's
+// bench lock, writing with probability writepct/100 and reading
+// otherwise, and hold it briefly.  Store the number of reads
+// and writes in counts[0] and counts[1].
+int
+rwbench(int policy, int writepct, uint start, uint end, int *counts)
+{
+  struct rwlock *lk;
+  uint seed;
+  int i;
+
+  if(policy < 0 || policy >= NELEM(benchrw))
+    return -1;
+  lk = &benchrw[policy];
+
+  acquire(&tickslock);
+  while(ticks < start)
+    sleep(&ticks, &tickslock);
+  release(&tickslock);
+
+  counts[0] = counts[1] = 0;
+  seed = myproc()->pid;
+  while(*(volatile uint*)&ticks < end){
+    seed = seed * 1103515245 + 12345;
+    if((seed >> 16) % 100 < writepct){
+      acquirewrite(lk);
+      for(i = 0; i < 100; i++)
+        pause();
+      benchval++;
+      releasewrite(lk);
+      counts[1]++;
+    } else {
+      acquireread(lk);
+      for(i = 0; i < 100; i++)
+        pause();
+      releaseread(lk);
+      counts[0]++;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,21 @@
+// Reader-writer locks.
+
+// Policies: who goes first when readers and writers both wait.
+#define RW_READERS    0   // Readers; writers may starve
+#define RW_WRITERS    1   // Writers; readers may starve
+#define RW_PHASEFAIR  2   // Alternate: a waiting writer holds off new
+                          // readers, but a releasing writer admits
+                          // all readers waiting at that point
+
+struct rwlock {
+  struct spinlock lk; // spinlock protecting this rwlock
+  int policy;         // RW_READERS, RW_WRITERS or RW_PHASEFAIR
+  int readers;        // Readers holding the lock
+  int writer;         // Is a writer holding the lock?
+  int rwait;          // Readers waiting
+  int wwait;          // Writers waiting
+  uint phase;         // Times waiting readers have been admitted
+
+  // For debugging:
+  char *name;         // Name of lock.
+};
@@ -14,15 +14,37 @@
 #define PIPE  3
 #define LIST  4
 #define BACK  5
-#define TAB 7
 #define MAXARGS 10
 
-// Program listing
-#define MAX_FILES 128
+// Directories searched, after the name as given, for commands
+// and for their completions.
+char *path[] = { "/", 0 };
+
 #define MAX_NAME (DIRSIZ + 1)
-int get_user_programs(char names[MAX_FILES][MAX_NAME]);
-void print_string_array(char arr[MAX_FILES][MAX_NAME], int count);
-int find_matches(char *prefix, char names[MAX_FILES][MAX_NAME],char matches[MAX_FILES][MAX_NAME], int count);
+#define NDIRCACHE 4   // "." and the path directories
+
+// Tab completion keeps the plain files of each directory it
+// searches, tagged with the directory's identity and generation,
+// and rereads a directory only when those change.  The names of all
+// of them, sorted and without duplicates, form the index that a
+// prefix is looked up in.
+struct dircache {
+  char *dir;
+  int dev;
+  uint ino;
+  uint gen;
+  char (*names)[MAX_NAME];
+  int n;
+  int cap;
+};
+
+struct dircache dircache[NDIRCACHE];
+char **cmdindex;
+int nindex;
+
+void pathjoin(char *buf, char *dir, char *name);
+void complete(char *line, int n, int again);
+void console_write(char *str);
 
 
 struct cmd {
@@ -62,14 +84,6 @@ struct backcmd {
 };
 
 
-struct tab
-{
-  int type;
-  char *cmd; 
-  int tab_check;
-};
-
-
 
 int fork1(void);  // Fork but panics on failure.
 void panic(char*);
@@ -85,6 +99,8 @@ runcmd(struct cmd *cmd)
   struct listcmd *lcmd;
   struct pipecmd *pcmd;
   struct redircmd *rcmd;
+  char buf[128];
+  int i;
 
   // struct exclamation *excmd; //we don't need this
 
@@ -95,42 +111,16 @@ runcmd(struct cmd *cmd)
   default:
     panic("runcmd");
     
-  case TAB: {
-    struct tab *tcmd = (struct tab*)cmd;
-
-    char (*programs)[MAX_NAME] = malloc(sizeof(char) * MAX_FILES * MAX_NAME);
-    char (*matches)[MAX_NAME]  = malloc(sizeof(char) * MAX_FILES * MAX_NAME);
-
-    if (!programs || !matches) {
-      printf(2, "malloc failed\n");
-      exit();
-    }
-
-    int n = get_user_programs(programs);
-    int m = find_matches(tcmd->cmd, programs, matches, n);
-
-    if(m == 1)
-      console_write(matches[0] );
-    
-    else if(m > 1 && tcmd->tab_check){
-      print_string_array(matches, m);
-      printf(1 , "$ ");
-      console_write(tcmd->cmd);
-    }
-    else
-      console_write(tcmd->cmd);
-    
-
-    free(programs);
-    free(matches);
-    break;
-  }
-  
   case EXEC:
     ecmd = (struct execcmd*)cmd;
     if(ecmd->argv[0] == 0)
       exit();
     exec(ecmd->argv[0], ecmd->argv);
+    if(strchr(ecmd->argv[0], '/') == 0)
+      for(i = 0; path[i]; i++){
+        pathjoin(buf, path[i], ecmd->argv[0]);
+        exec(buf, ecmd->argv);
+      }
     printf(2, "exec %s failed\n", ecmd->argv[0]);
     break;
 
@@ -212,7 +202,7 @@ int
 main(void)
 {
   static char output[100];
-  int fd;
+  int fd, n;
 
   // Ensure that three file descriptors are open.
   while((fd = open("console", O_RDWR)) >= 0){
@@ -224,6 +214,14 @@ main(void)
 
   // Read and run input commands.
   while(getcmd(output, sizeof(output)) >= 0){
+    // On Tab the console sends the line so far, 'T' if Tab was
+    // pressed twice in a row (else 'F'), then "\t\n".  Complete
+    // here rather than in a child, so the index outlives it.
+    n = strlen(output);
+    if(n > 2 && output[n-2] == '\t'){
+      complete(output, n - 3, output[n-3] == 'T');
+      continue;
+    }
     if(output[0] == 'c' && output[1] == 'd' && output[2] == ' '){
       // Chdir must be called by the parent, not the child.
       output[strlen(output)-1] = 0;  // chop \n
@@ -397,18 +395,6 @@ parsecmd(char *s)
   char *es;
   struct cmd *cmd;
   
-  int len = strlen(s);
-  
-  if (len > 2 && s[len - 2] == '\t') {
-    struct tab *tcmd = malloc(sizeof(*tcmd));
-    memset(tcmd, 0, sizeof(*tcmd));
-    tcmd->type = TAB;
-    tcmd->tab_check = (s[len - 3] == 'T') ? 1 : 0; // if there was a T before tab
-    s[len - 3] = '\0';
-    tcmd->cmd = s;
-    return (struct cmd*)tcmd;
-  }
-
   es = s + strlen(s);
   cmd = parseline(&s, es);
   peek(&s, es, "");
@@ -596,96 +582,187 @@ strncmp(const char *p, const char *q, uint n)
 }
 
 
-int get_user_programs(char names[MAX_FILES][MAX_NAME]) {
-  char buf[512], *p;
-  int fd;
-  struct dirent de;
-  struct stat st;
-  int count = 0;
+// Join dir and name into buf, which holds 128 bytes.
+void
+pathjoin(char *buf, char *dir, char *name)
+{
+  int n;
 
-  if((fd = open(".", 0)) < 0){
-    printf(2, "list_programs: cannot open .\n");
-    return -1;
+  n = strlen(dir);
+  if(n + 1 + strlen(name) >= 128){
+    buf[0] = 0;
+    return;
   }
+  strcpy(buf, dir);
+  if(n > 0 && dir[n-1] != '/')
+    buf[n++] = '/';
+  strcpy(buf + n, name);
+}
 
-  if(fstat(fd, &st) < 0){
-    printf(2, "list_programs: cannot stat .\n");
-    close(fd);
-    return -1;
-  }
+// Bring c up to date with its directory.  Return 1 if its
+// names changed, 0 if they are still current.
+int
+scandir(struct dircache *c)
+{
+  char buf[128], name[MAX_NAME], (*names)[MAX_NAME];
+  struct dirent de;
+  struct stat st;
+  int fd, cap;
 
-  if(st.type != T_DIR){
-    printf(2, "list_programs: not a directory\n");
+  if((fd = open(c->dir, 0)) < 0 || fstat(fd, &st) < 0 || st.type != T_DIR){
+    if(fd >= 0)
+      close(fd);
+    if(c->n == 0)
+      return 0;
+    c->n = 0;
+    return 1;
+  }
+  if(c->names && st.dev == c->dev && st.ino == c->ino && st.gen == c->gen){
     close(fd);
-    return -1;
+    return 0;
   }
-
+  c->dev = st.dev;
+  c->ino = st.ino;
+  c->gen = st.gen;
+  c->n = 0;
   while(read(fd, &de, sizeof(de)) == sizeof(de)){
     if(de.inum == 0)
       continue;
-    if(count >= MAX_FILES)
-      break;
-
-    strcpy(buf, "./");
-    p = buf + strlen(buf);
-    memmove(p, de.name, DIRSIZ);
-    p[DIRSIZ - 1] = 0;
-
-    if(stat(buf, &st) < 0)
+    memmove(name, de.name, DIRSIZ);
+    name[DIRSIZ] = 0;
+    if(strncmp(name, "README", 6) == 0)
       continue;
-
-    if(st.type == T_FILE){
-      if(strncmp(de.name, "README", 6) == 0)
-        continue;
-
-      memmove(names[count], de.name, DIRSIZ - 1);
-      names[count][DIRSIZ - 1] = 0;
-      count++;
+    pathjoin(buf, c->dir, name);
+    if(stat(buf, &st) < 0 || st.type != T_FILE)
+      continue;
+    if(c->n == c->cap){
+      cap = c->cap ? 2*c->cap : 64;
+      if((names = malloc(cap * MAX_NAME)) == 0){
+        printf(2, "sh: out of memory\n");
+        break;
+      }
+      memmove(names, c->names, c->n * MAX_NAME);
+      free(c->names);
+      c->names = names;
+      c->cap = cap;
     }
+    strcpy(c->names[c->n++], name);
   }
-
   close(fd);
-
-  safestrcpy(names[count++], "cd",      MAX_NAME);
-  // safestrcpy(names[count++], "exit",    MAX_NAME);
-  // safestrcpy(names[count++], "help",    MAX_NAME);
-  // safestrcpy(names[count++], "history", MAX_NAME);
-
-  return count;
+  return 1;
 }
 
+// Rebuild cmdindex from the directory caches and the builtins.
+void
+buildindex(void)
+{
+  static char *builtins[] = { "cd", 0 };
+  char *t;
+  int i, j, k, n, gap;
+
+  n = 0;
+  for(i = 0; dircache[i].dir; i++)
+    n += dircache[i].n;
+  free(cmdindex);
+  nindex = 0;
+  if((cmdindex = malloc((n + sizeof(builtins)/sizeof(builtins[0])) * sizeof(char*))) == 0)
+    return;
+  for(i = 0; dircache[i].dir; i++)
+    for(j = 0; j < dircache[i].n; j++)
+      cmdindex[nindex++] = dircache[i].names[j];
+  for(i = 0; builtins[i]; i++)
+    cmdindex[nindex++] = builtins[i];
+
+  // Shell sort, then drop duplicates.
+  for(gap = nindex/2; gap > 0; gap /= 2)
+    for(i = gap; i < nindex; i++)
+      for(j = i - gap; j >= 0 && strcmp(cmdindex[j], cmdindex[j+gap]) > 0; j -= gap){
+        t = cmdindex[j];
+        cmdindex[j] = cmdindex[j+gap];
+        cmdindex[j+gap] = t;
+      }
+  for(i = k = 0; i < nindex; i++)
+    if(k == 0 || strcmp(cmdindex[k-1], cmdindex[i]) != 0)
+      cmdindex[k++] = cmdindex[i];
+  nindex = k;
+}
 
+// Set *first to the first index entry starting with prefix
+// and return how many entries do.
 int
-find_matches(char *prefix, char names[MAX_FILES][MAX_NAME],
-             char matches[MAX_FILES][MAX_NAME], int count)
+lookup(char *prefix, int *first)
 {
-  int prefix_len = strlen(prefix);
-  if(prefix_len == 0)
-    return 0;
-  int mcount = 0;
-
-  for (int i = 0; i < count; i++) {
-    if (strncmp(prefix, names[i], prefix_len) == 0) {
-      if (mcount < MAX_FILES) {
-        safestrcpy(matches[mcount], names[i], MAX_NAME);
-        mcount++;
-      }
-    }
+  int lo, hi, mid, n;
+
+  n = strlen(prefix);
+  lo = 0;
+  hi = nindex;
+  while(lo < hi){
+    mid = (lo + hi) / 2;
+    if(strcmp(cmdindex[mid], prefix) < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
   }
-
-  return mcount;
+  *first = lo;
+  for(hi = lo; hi < nindex && strncmp(prefix, cmdindex[hi], n) == 0; hi++)
+    ;
+  return hi - lo;
 }
 
+// Complete the command name at the end of line[0..n) and send
+// the line back to the console.  The name is extended by the
+// longest prefix its matches share; if again, the matches are
+// listed as well.
 void
-print_string_array(char arr[MAX_FILES][MAX_NAME], int count)
+complete(char *line, int n, int again)
 {
-  printf(1, "\n-----------------\n");
-  for (int i = 0; i < count; i++) {
-    if (arr[i][0] == 0)
-      continue; // skip empty strings
-    printf(1, "  %s\n", arr[i]);
+  char buf[100], *word;
+  int i, m, first, lcp, changed;
+
+  if(n >= sizeof(buf) - MAX_NAME)
+    n = sizeof(buf) - MAX_NAME - 1;
+  memmove(buf, line, n);
+  buf[n] = 0;
+  word = buf + n;
+  while(word > buf && !strchr(" \t|;&()<>", word[-1]))
+    word--;
+  // Only names in command position are completed.
+  for(i = word - buf; i > 0 && strchr(" \t", buf[i-1]); i--)
+    ;
+  if(i > 0 && !strchr("|;&(", buf[i-1])){
+    console_write(buf);
+    return;
   }
-  printf(1, "-----------------\n");
+
+  if(dircache[0].dir == 0){
+    dircache[0].dir = ".";
+    for(i = 0; path[i] && i + 1 < NDIRCACHE; i++)
+      dircache[i+1].dir = path[i];
+  }
+  changed = cmdindex == 0;
+  for(i = 0; dircache[i].dir; i++)
+    changed |= scandir(&dircache[i]);
+  if(changed)
+    buildindex();
+
+  if((m = lookup(word, &first)) == 0){
+    console_write(buf);
+    return;
+  }
+  lcp = strlen(cmdindex[first]);
+  for(i = first + 1; i < first + m; i++)
+    while(strncmp(cmdindex[first], cmdindex[i], lcp) != 0)
+      lcp--;
+  if(m > 1 && again){
+    printf(1, "\n-----------------\n");
+    for(i = first; i < first + m; i++)
+      printf(1, "  %s\n", cmdindex[i]);
+    printf(1, "-----------------\n$ ");
+  }
+  memmove(word, cmdindex[first], lcp);
+  word[lcp] = 0;
+  console_write(buf);
 }
 
 void*
@@ -698,7 +775,12 @@ void
 console_write(char *str)
 {
   char tab_buf[128];
+  int n;
+
+  n = strlen(str);
+  if(n > sizeof(tab_buf) - 1)
+    n = sizeof(tab_buf) - 1;
   tab_buf[0] = '\x01';
-  memcpy(tab_buf + 1, str, strlen(str));
-  write(1, tab_buf, strlen(str) + 1);
+  memcpy(tab_buf + 1, str, n);
+  write(1, tab_buf, n + 1);
 }
@@ -17,17 +17,49 @@ initsleeplock(struct sleeplock *lk, char *name)
   lk->name = name;
   lk->locked = 0;
   lk->pid = 0;
+  lk->owner = 0;
+  lk->class = lockclass(name, 1);
+  lk->tsc = 0;
 }
 
+// If the lock is held by a process running on another CPU,
+// spin for up to SLEEPSPIN cycles before sleeping: the short
+// inode and buffer critical sections usually end sooner than
+// a sleep and wakeup would take.
 void
 acquiresleep(struct sleeplock *lk)
 {
+  uint64 start, spinstart;
+  int contended, spun;
+  struct proc *owner;
+
   acquire(&lk->lk);
+  start = rdtsc();
+  contended = lk->locked;
+  spun = 0;
   while (lk->locked) {
+    owner = lk->owner;
+    if(!spun && owner != 0 && owner->state == RUNNING){
+      spun = 1;
+      release(&lk->lk);
+      spinstart = rdtsc();
+      while(lk->locked && lk->owner == owner && owner->state == RUNNING &&
+            rdtsc() - spinstart < SLEEPSPIN)
+        pause();
+      acquire(&lk->lk);
+      if(lockstat_on && lk->class)
+        lockstat_spun(lk->class, !lk->locked);
+      continue;
+    }
     sleep(lk, &lk->lk);
   }
   lk->locked = 1;
   lk->pid = myproc()->pid;
+  lk->owner = myproc();
+  if(lockstat_on && lk->class){
+    lk->tsc = rdtsc();
+    lockstat_acquired(lk->class, lk->tsc - start, contended);
+  }
   release(&lk->lk);
 }
 
@@ -35,8 +67,13 @@ void
 releasesleep(struct sleeplock *lk)
 {
   acquire(&lk->lk);
+  if(lk->tsc){
+    lockstat_released(lk->class, rdtsc() - lk->tsc);
+    lk->tsc = 0;
+  }
   lk->locked = 0;
   lk->pid = 0;
+  lk->owner = 0;
   wakeup(lk);
   release(&lk->lk);
 }
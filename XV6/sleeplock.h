@@ -6,5 +6,10 @@ struct sleeplock {
   // For debugging:
   char *name;        // Name of lock.
   int pid;           // Process holding lock
+  struct proc *owner; // Process holding lock, for adaptive spinning
+
+  // For contention statistics (lockclass.c):
+  struct lockclass *class;
+  uint64 tsc;        // When acquired, or 0 if not measured
 };
 
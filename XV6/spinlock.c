@@ -14,7 +14,51 @@ initlock(struct spinlock *lk, char *name)
 {
   lk->name = name;
   lk->locked = 0;
+  lk->ticketed = 0;
+  lk->next = 0;
+  lk->owner = 0;
   lk->cpu = 0;
+  lk->class = lockclass(name, 0);
+  lk->tsc = 0;
+}
+
+// Initialize a ticket lock.  Under contention a plain lock
+// goes to whichever CPU's xchg wins, so a CPU can starve;
+// a ticket lock serves waiters in arrival order.
+void
+initticketlock(struct spinlock *lk, char *name)
+{
+  initlock(lk, name);
+  lk->ticketed = 1;
+}
+
+// Wait until lk is ours.  Return 1 if we had to wait.
+static int
+spin(struct spinlock *lk)
+{
+  uint t;
+  int contended;
+
+  contended = 0;
+  if(lk->ticketed){
+    t = fetchadd(&lk->next, 1);
+    while(lk->owner != t){
+      contended = 1;
+      pause();
+    }
+    lk->locked = 1;
+    return contended;
+  }
+
+  // The xchg is atomic.  While the lock is held, spin reading
+  // it instead, so waiters share its cache line rather than
+  // pulling it away from each other with xchg.
+  while(xchg(&lk->locked, 1) != 0){
+    contended = 1;
+    while(lk->locked)
+      pause();
+  }
+  return contended;
 }
 
 // Acquire the lock.
@@ -24,13 +68,20 @@ initlock(struct spinlock *lk, char *name)
 void
 acquire(struct spinlock *lk)
 {
+  uint64 start;
+  int contended;
+
   pushcli(); // disable interrupts to avoid deadlock.
   if(holding(lk))
     panic("acquire");
 
-  // The xchg is atomic.
-  while(xchg(&lk->locked, 1) != 0)
-    ;
+  if(lockstat_on && lk->class){
+    start = rdtsc();
+    contended = spin(lk);
+    lk->tsc = rdtsc();
+    lockstat_acquired(lk->class, lk->tsc - start, contended);
+  } else
+    spin(lk);
 
   // Tell the C compiler and the processor to not move loads or stores
   // past this point, to ensure that the critical section's memory
@@ -52,6 +103,11 @@ release(struct spinlock *lk)
   lk->pcs[0] = 0;
   lk->cpu = 0;
 
+  if(lk->tsc){
+    lockstat_released(lk->class, rdtsc() - lk->tsc);
+    lk->tsc = 0;
+  }
+
   // Tell the C compiler and the processor to not move loads or stores
   // past this point, to ensure that all the stores in the critical
   // section are visible to other cores before the lock is released.
@@ -64,9 +120,43 @@ release(struct spinlock *lk)
   // not be atomic. A real OS would use C atomics here.
   asm volatile("movl $0, %0" : "+m" (lk->locked) : );
 
+  // Pass a ticket lock to the next waiter.  Only the holder
+  // writes owner, so this need not be atomic either.
+  if(lk->ticketed)
+    asm volatile("movl %1, %0" : "+m" (lk->owner) : "r" (lk->owner + 1));
+
   popcli();
 }
 
+// Locks for the lockbench system call.
+static struct spinlock benchlock[2] = {
+  { .name = "bench" },
+  { .name = "bench.ticket", .ticketed = 1 },
+};
+static uint benchcount;
+
+// Between ticks start and end, repeatedly acquire and release
+// a plain (ticketed == 0) or ticket lock shared by all callers.
+// Return the number of acquisitions.
+int
+lockbench(int ticketed, uint start, uint end)
+{
+  struct spinlock *lk = &benchlock[ticketed != 0];
+  int n;
+
+  acquire(&tickslock);
+  while(ticks < start)
+    sleep(&ticks, &tickslock);
+  release(&tickslock);
+
+  for(n = 0; *(volatile uint*)&ticks < end; n++){
+    acquire(lk);
+    benchcount++;
+    release(lk);
+  }
+  return n;
+}
+
 // Record the current call stack in pcs[] by following the %ebp chain.
 void
 getcallerpcs(void *v, uint pcs[])
@@ -2,10 +2,21 @@
 struct spinlock {
   uint locked;       // Is the lock held?
 
+  // Ticket locks (initticketlock) are granted in FIFO order:
+  // an acquirer takes the next ticket and waits for owner
+  // to reach it.
+  int ticketed;
+  uint next;         // Next ticket to hand out
+  uint owner;        // Ticket now allowed to hold the lock
+
   // For debugging:
   char *name;        // Name of lock.
   struct cpu *cpu;   // The cpu holding the lock.
   uint pcs[10];      // The call stack (an array of program counters)
                      // that locked the lock.
+
+  // For contention statistics (lockclass.c):
+  struct lockclass *class;  // Statistics shared by locks with this name
+  uint64 tsc;        // When acquired, or 0 if not measured
 };
 
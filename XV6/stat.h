@@ -8,4 +8,16 @@ struct stat {
   uint ino;    // Inode number
   short nlink; // Number of links to file
   uint size;   // Size of file in bytes
+  uint mtime;  // Contents last modified, seconds since 2000
+  uint ctime;  // Inode last changed, seconds since 2000
+  uint gen;    // Changes to the contents; equal gens mean equal contents
+};
+
+// File system cache statistics, filled in by fsstat().
+struct fsstat {
+  uint dcache_hits;     // Path components found in the dentry cache
+  uint dcache_neghits;  // ... of which were cached as absent
+  uint dcache_misses;   // Path components that read the directory
+  uint icache_hits;     // iget() calls that found the inode cached
+  uint icache_misses;   // iget() calls that recycled a cache entry
 };
@@ -0,0 +1,169 @@
+#include "types.h"
+#include "param.h"
+#include "stat.h"
+#include "user.h"
+#include "syscall.h"
+#include "trace.h"
+#include "sysnames.h"
+
+// strace command [args...]
+//
+// Runs command with every system call traced and prints the
+// records made by it and the processes it forks.  The rings are
+// drained by a child process, woken once a tick by a second child
+// through a pipe; the parent itself just wait()s for the command.
+// Once the command has exited, the parent stops the ticker, which
+// closes the pipe and has the drainer empty the rings and exit.
+
+#define NBATCH 32
+#define NPIDS 64
+#define NPENDING 64
+
+static struct tracerec buf[NBATCH];
+
+// Pids known to belong to the traced command: its own and those
+// it, or they, forked.
+static int pids[NPIDS];
+static int npids;
+
+// Records whose pid is not (yet) known.  On SMP a child's records
+// can be read before the fork record that names it, so they wait
+// here for it; the oldest are dropped when this fills up.
+static struct tracerec pending[NPENDING];
+static int npending;
+
+static int traced(int pid) {
+    int i;
+
+    for(i = 0; i < npids; i++)
+        if(pids[i] == pid)
+            return 1;
+    return 0;
+}
+
+static void print(struct tracerec *r) {
+    if(r->num > 0 && r->num < NSYSNAMES && sysnames[r->num])
+        printf(1, "[%d] %s", r->pid, sysnames[r->num]);
+    else
+        printf(1, "[%d] syscall %d", r->pid, r->num);
+    printf(1, "(0x%x, 0x%x, 0x%x) = %d  <%d cycles>\n",
+           r->args[0], r->args[1], r->args[2], r->ret, r->cycles);
+}
+
+static void record(struct tracerec *r) {
+    print(r);
+    if(r->num == SYS_fork && r->ret > 0 && npids < NPIDS)
+        pids[npids++] = r->ret;
+}
+
+static void defer(struct tracerec *r) {
+    if(npending == NPENDING) {
+        memmove(pending, pending + 1, (NPENDING - 1) * sizeof(pending[0]));
+        npending--;
+    }
+    pending[npending++] = *r;
+}
+
+// Print the pending records whose pids are now known.
+static void retry(void) {
+    int i, j, found;
+
+    do {
+        found = 0;
+        for(i = j = 0; i < npending; i++) {
+            if(traced(pending[i].pid)) {
+                record(&pending[i]);
+                found = 1;
+            } else
+                pending[j++] = pending[i];
+        }
+        npending = j;
+    } while(found);
+}
+
+// Print the traced command's records until the rings are empty.
+static void drain(void) {
+    struct tracerec *r;
+    uint lost;
+    int i, n, before;
+
+    while((n = traceread(buf, NBATCH, &lost)) > 0 || lost > 0) {
+        if(lost > 0)
+            printf(1, "strace: %d records lost\n", lost);
+        before = npids;
+        for(i = 0; i < n; i++) {
+            r = &buf[i];
+            if(traced(r->pid))
+                record(r);
+            else
+                defer(r);
+        }
+        if(npids != before)
+            retry();
+    }
+}
+
+static int spawn(void) {
+    int pid;
+
+    if((pid = fork()) < 0) {
+        printf(2, "strace: fork failed\n");
+        exit();
+    }
+    return pid;
+}
+
+int main(int argc, char* argv[]) {
+    uint mask[TRACE_MASKWORDS];
+    int i, pid, ticker, p[2];
+    char c;
+
+    if(argc < 2) {
+        printf(2, "usage: strace command [args...]\n");
+        exit();
+    }
+
+    for(i = 0; i < TRACE_MASKWORDS; i++)
+        mask[i] = ~0;
+
+    // Throw away whatever is already in the rings.
+    while(traceread(buf, NBATCH, (uint*)&i) > 0)
+        ;
+
+    if(pipe(p) < 0) {
+        printf(2, "strace: pipe failed\n");
+        exit();
+    }
+    if((pid = spawn()) == 0) {
+        close(p[0]);
+        close(p[1]);
+        settrace(getpid(), mask);
+        exec(argv[1], argv + 1);
+        printf(2, "strace: exec %s failed\n", argv[1]);
+        exit();
+    }
+    if(spawn() == 0) {
+        close(p[1]);
+        pids[npids++] = pid;
+        while(read(p[0], &c, 1) == 1)
+            drain();
+        drain();
+        exit();
+    }
+    if((ticker = spawn()) == 0) {
+        close(p[0]);
+        do
+            sleep(1);
+        while(write(p[1], "t", 1) == 1);
+        exit();
+    }
+    close(p[0]);
+    close(p[1]);
+
+    while((i = wait()) >= 0 && i != pid)
+        ;
+    kill(ticker);
+    while(wait() >= 0)
+        ;
+    exit();
+}
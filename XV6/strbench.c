@@ -0,0 +1,150 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "x86.h"
+
+// Compares the library's string and memory routines with
+// byte-at-a-time loops, in bytes per cycle.
+
+#define TOTAL   (4*1024*1024)   // Bytes processed per measurement
+#define MAXSIZE 65536
+#define NELEM(x) (sizeof(x)/sizeof((x)[0]))
+
+static char *src, *dst;
+static volatile uint sink;
+
+static void __attribute__((noinline))
+bytememset(void *d, int c, uint n)
+{
+    volatile char *p = d;
+
+    while(n-- > 0)
+        *p++ = c;
+}
+
+static void __attribute__((noinline))
+bytememmove(void *d, const void *s, int n)
+{
+    volatile char *p = d;
+    const char *q = s;
+
+    while(n-- > 0)
+        *p++ = *q++;
+}
+
+static int __attribute__((noinline))
+bytememcmp(const void *v1, const void *v2, uint n)
+{
+    const volatile uchar *s1 = v1, *s2 = v2;
+
+    for(; n > 0; n--, s1++, s2++)
+        if(*s1 != *s2)
+            return *s1 - *s2;
+    return 0;
+}
+
+static uint __attribute__((noinline))
+bytestrlen(const char *s)
+{
+    const volatile char *p = s;
+
+    while(*p)
+        p++;
+    return p - s;
+}
+
+static char* __attribute__((noinline))
+bytestrchr(const char *s, char c)
+{
+    const volatile char *p = s;
+
+    for(; *p; p++)
+        if(*p == c)
+            return (char*)p;
+    return 0;
+}
+
+static void* __attribute__((noinline))
+bytememchr(const void *v, int c, uint n)
+{
+    const volatile uchar *p = v;
+
+    for(; n > 0; n--, p++)
+        if(*p == (uchar)c)
+            return (void*)p;
+    return 0;
+}
+
+// Run primitive prim, fast or bytewise, over size bytes until
+// TOTAL bytes are done; return hundredths of a byte per cycle.
+static uint run(int prim, int fast, int size) {
+    uint64 start;
+    uint cycles;
+    int i, reps;
+
+    // Strings are size-1 bytes of 'a' and a NUL; memchr and
+    // strchr look for a byte that is not there.
+    memset(src, 'a', size);
+    src[size-1] = 0;
+    memmove(dst, src, size);
+    reps = TOTAL / size;
+    start = rdtsc();
+    for(i = 0; i < reps; i++) {
+        switch(prim) {
+        case 0:
+            fast ? memset(dst, i, size) : bytememset(dst, i, size);
+            break;
+        case 1:
+            fast ? memmove(dst, src, size) : bytememmove(dst, src, size);
+            break;
+        case 2:
+            sink = fast ? memcmp(dst, src, size) : bytememcmp(dst, src, size);
+            break;
+        case 3:
+            sink = fast ? strlen(src) : bytestrlen(src);
+            break;
+        case 4:
+            sink = (uint)(fast ? strchr(src, 'b') : bytestrchr(src, 'b'));
+            break;
+        case 5:
+            sink = (uint)(fast ? memchr(src, 'b', size) : bytememchr(src, 'b', size));
+            break;
+        }
+    }
+    cycles = (uint)(rdtsc() - start);
+    if(cycles < 100)
+        cycles = 100;
+    return (uint)reps * size / (cycles / 100);
+}
+
+static void printrate(uint r) {
+    printf(1, "\t%d.%d%d", r / 100, r / 10 % 10, r % 10);
+}
+
+int main(int argc, char* argv[]) {
+    static char *names[] = { "memset", "memmove", "memcmp", "strlen", "strchr", "memchr" };
+    static int sizes[] = { 64, 4096, MAXSIZE };
+    int p, s;
+
+    src = malloc(MAXSIZE + 8);
+    dst = malloc(MAXSIZE + 8);
+    if(src == 0 || dst == 0) {
+        printf(2, "strbench: out of memory\n");
+        exit();
+    }
+    // Misaligned by a byte, so the word loops need a head and tail.
+    src++;
+    dst++;
+
+    printf(1, "bytes/cycle\tsize\tbytewise\tlibrary\n");
+    for(p = 0; p < NELEM(names); p++) {
+        for(s = 0; s < NELEM(sizes); s++) {
+            printf(1, "%s\t\t%d", names[p], sizes[s]);
+            printrate(run(p, 0, sizes[s]));
+            printf(1, "\t");
+            printrate(run(p, 1, sizes[s]));
+            printf(1, "\n");
+        }
+    }
+    exit();
+}
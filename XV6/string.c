@@ -1,14 +1,36 @@
 #include "types.h"
 #include "x86.h"
 
+// These work a word at a time where they can.  A word with a
+// zero byte is found with the usual carry trick (HASZERO);
+// aligned word loads never cross a page, so reading past the end
+// of a string within its last word is safe.
+#define ONES        0x01010101
+#define HASZERO(x)  (((x) - ONES) & ~(x) & 0x80808080)
+
+// Both pointers are equally misaligned, so aligning one aligns both.
+#define COALIGNED(p, q)  ((((uint)(p) ^ (uint)(q)) & 3) == 0)
+
 void*
 memset(void *dst, int c, uint n)
 {
-  if ((int)dst%4 == 0 && n%4 == 0){
-    c &= 0xFF;
-    stosl(dst, (c<<24)|(c<<16)|(c<<8)|c, n/4);
-  } else
-    stosb(dst, c, n);
+  char *d;
+  uint k;
+
+  d = dst;
+  c &= 0xFF;
+  if(n >= 8){
+    // Bytes up to a word boundary, then words; a page is a single
+    // rep stosl.
+    k = -(uint)d & 3;
+    stosb(d, c, k);
+    d += k;
+    n -= k;
+    stosl(d, (uint)c * ONES, n / 4);
+    d += n & ~3;
+    n &= 3;
+  }
+  stosb(d, c, n);
   return dst;
 }
 
@@ -19,6 +41,14 @@ memcmp(const void *v1, const void *v2, uint n)
 
   s1 = v1;
   s2 = v2;
+  if(COALIGNED(s1, s2)){
+    for(; n > 0 && ((uint)s1 & 3); n--, s1++, s2++)
+      if(*s1 != *s2)
+        return *s1 - *s2;
+    // Skip equal words; a differing one is compared bytewise.
+    for(; n >= 4 && *(uint*)s1 == *(uint*)s2; n -= 4)
+      s1 += 4, s2 += 4;
+  }
   while(n-- > 0){
     if(*s1 != *s2)
       return *s1 - *s2;
@@ -33,18 +63,39 @@ memmove(void *dst, const void *src, uint n)
 {
   const char *s;
   char *d;
+  uint k;
 
   s = src;
   d = dst;
   if(s < d && s + n > d){
     s += n;
     d += n;
+    if(COALIGNED(s, d) && n >= 8){
+      for(; (uint)d & 3; n--)
+        *--d = *--s;
+      for(; n >= 4; n -= 4){
+        s -= 4;
+        d -= 4;
+        *(uint*)d = *(uint*)s;
+      }
+    }
     while(n-- > 0)
       *--d = *--s;
-  } else
-    while(n-- > 0)
-      *d++ = *s++;
+    return dst;
+  }
 
+  if(COALIGNED(s, d) && n >= 8){
+    k = -(uint)d & 3;
+    movsb(d, s, k);
+    d += k;
+    s += k;
+    n -= k;
+    movsl(d, s, n / 4);
+    d += n & ~3;
+    s += n & ~3;
+    n &= 3;
+  }
+  movsb(d, s, n);
   return dst;
 }
 
@@ -96,10 +147,16 @@ safestrcpy(char *s, const char *t, int n)
 int
 strlen(const char *s)
 {
-  int n;
+  const char *p;
+  const uint *w;
 
-  for(n = 0; s[n]; n++)
+  for(p = s; (uint)p & 3; p++)
+    if(*p == 0)
+      return p - s;
+  for(w = (const uint*)p; !HASZERO(*w); w++)
+    ;
+  for(p = (const char*)w; *p; p++)
     ;
-  return n;
+  return p - s;
 }
 
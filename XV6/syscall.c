@@ -6,7 +6,7 @@
 #include "proc.h"
 #include "x86.h"
 #include "syscall.h"
-#include "user_mgmt.h"
+#include "trace.h"
 
 // User code makes a system call with INT T_SYSCALL.
 // System call number in %eax.
@@ -116,6 +116,20 @@ extern int  sys_logs(void);
 extern int sys_diff(void);
 
 extern int sys_list_programs(void);
+extern int sys_fsstat(void);
+extern int sys_settrace(void);
+extern int sys_traceread(void);
+extern int sys_sysstat(void);
+extern int sys_profstart(void);
+extern int sys_profstop(void);
+extern int sys_profread(void);
+extern int sys_lockstat(void);
+extern int sys_lockbench(void);
+extern int sys_rwbench(void);
+extern int sys_uartstat(void);
+extern int sys_lseek(void);
+extern int sys_auditread(void);
+extern int sys_setsid(void);
 
 extern int sys_create_realtime_process(void); //additional
 extern int sys_change_process_queue(void); 
@@ -173,52 +187,41 @@ static int (*syscalls[])(void) = {
 [SYS_critical_section] sys_critical_section,
 
 [SYS_list_programs] sys_list_programs,
+[SYS_fsstat] sys_fsstat,
+[SYS_settrace] sys_settrace,
+[SYS_traceread] sys_traceread,
+[SYS_sysstat] sys_sysstat,
+[SYS_profstart] sys_profstart,
+[SYS_profstop] sys_profstop,
+[SYS_profread] sys_profread,
+[SYS_lockstat] sys_lockstat,
+[SYS_lockbench] sys_lockbench,
+[SYS_rwbench] sys_rwbench,
+[SYS_uartstat] sys_uartstat,
+[SYS_lseek] sys_lseek,
+[SYS_auditread] sys_auditread,
+[SYS_setsid] sys_setsid,
 };
 
-int 
-should_log_syscall(int num) {
-  int allowed[] = {
-    SYS_make_user,
-    SYS_login,
-    SYS_logout,
-    SYS_next_palindrome,
-    SYS_mkdir,
-    SYS_open,
-    SYS_unlink,
-    SYS_exec,
-    SYS_fork,
-    SYS_kill,
-    SYS_wait,
-    SYS_chdir,
-    SYS_getpid,
-    SYS_sbrk,
-    SYS_sleep,
-    SYS_uptime,
-    SYS_logs,
-  };
-  int len = sizeof(allowed) / sizeof(int);
-  for(int i = 0; i < len; i++)
-    if (allowed[i] == num)
-      return 1;
-  return 0;
-}
-
-
 void
 syscall(void)
 {
-  int num;
+  int num, traced;
   struct proc *curproc = myproc();
+  struct tracerec r;
+  uint64 start, end;
 
   num = curproc->tf->eax;
   if(num > 0 && num < NELEM(syscalls) && syscalls[num]) {
+    traced = tracewanted(curproc, num);
+    if(traced)
+      tracebegin(&r, num);
+    start = rdtsc();
     curproc->tf->eax = syscalls[num]();
-    
-    //Add authorized system call
-    if (curproc->name[0] != '\0' && curproc->pid > 2 && should_log_syscall(num)) {
-      log_syscall(num);
-    }
-
+    end = rdtsc();
+    sysstatadd(num, end - start);
+    if(traced)
+      traceend(&r, start, end, curproc->tf->eax);
   } else {
     cprintf("%d %s: unknown sys call %d\n",
             curproc->pid, curproc->name, num);
@@ -45,3 +45,17 @@
 #define SYS_critical_section 38
 
 #define SYS_list_programs 39
+#define SYS_fsstat 40
+#define SYS_settrace 41
+#define SYS_traceread 42
+#define SYS_sysstat 43
+#define SYS_profstart 44
+#define SYS_profstop 45
+#define SYS_profread 46
+#define SYS_lockstat 47
+#define SYS_lockbench 48
+#define SYS_rwbench 49
+#define SYS_uartstat 50
+#define SYS_lseek 51
+#define SYS_auditread 52
+#define SYS_setsid 53
@@ -103,6 +103,17 @@ sys_close(void)
   return 0;
 }
 
+int
+sys_lseek(void)
+{
+  struct file *f;
+  int off, whence;
+
+  if(argfd(0, 0, &f) < 0 || argint(1, &off) < 0 || argint(2, &whence) < 0)
+    return -1;
+  return fileseek(f, off, whence);
+}
+
 int
 sys_fstat(void)
 {
@@ -138,6 +149,7 @@ sys_link(void)
   }
 
   ip->nlink++;
+  ichange(ip, 0);
   iupdate(ip);
   iunlock(ip);
 
@@ -171,10 +183,10 @@ isdirempty(struct inode *dp)
   int off;
   struct dirent de;
 
-  for(off=2*sizeof(de); off<dp->size; off+=sizeof(de)){
+  for(off=0; off<dp->size; off+=sizeof(de)){
     if(readi(dp, (char*)&de, off, sizeof(de)) != sizeof(de))
       panic("isdirempty: readi");
-    if(de.inum != 0)
+    if(de.inum != 0 && namecmp(de.name, ".") != 0 && namecmp(de.name, "..") != 0)
       return 0;
   }
   return 1;
@@ -185,7 +197,6 @@ int
 sys_unlink(void)
 {
   struct inode *ip, *dp;
-  struct dirent de;
   char name[DIRSIZ], *path;
   uint off;
 
@@ -215,9 +226,7 @@ sys_unlink(void)
     goto bad;
   }
 
-  memset(&de, 0, sizeof(de));
-  if(writei(dp, (char*)&de, off, sizeof(de)) != sizeof(de))
-    panic("unlink: writei");
+  dirunlink(dp, off);
   if(ip->type == T_DIR){
     dp->nlink--;
     iupdate(dp);
@@ -225,6 +234,7 @@ sys_unlink(void)
   iunlockput(dp);
 
   ip->nlink--;
+  ichange(ip, 0);
   iupdate(ip);
   iunlockput(ip);
 
@@ -442,3 +452,14 @@ sys_pipe(void)
   fd[1] = fd1;
   return 0;
 }
+
+int
+sys_fsstat(void)
+{
+  struct fsstat *st;
+
+  if(argptr(0, (void*)&st, sizeof(*st)) < 0)
+    return -1;
+  fsstat(st);
+  return 0;
+}
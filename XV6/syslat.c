@@ -0,0 +1,64 @@
+#include "types.h"
+#include "param.h"
+#include "stat.h"
+#include "user.h"
+#include "syscall.h"
+#include "trace.h"
+#include "sysnames.h"
+
+static struct sysstat st;
+
+// Upper bound, in cycles, of the histogram bucket holding
+// the call at fraction pct/100 of the n calls in h.
+void printpct(uint *h, uint n, int pct) {
+    uint want, seen;
+    int b;
+
+    want = (n * pct + 99) / 100;
+    seen = 0;
+    for(b = 0; b < NLATBUCKET - 1; b++) {
+        seen += h[b];
+        if(seen >= want)
+            break;
+    }
+    if(b == NLATBUCKET - 1)
+        printf(1, "\t>2^%d", b);
+    else if(b < 30)
+        printf(1, "\t%d", 2 << b);
+    else
+        printf(1, "\t2^%d", b + 1);
+}
+
+int main(int argc, char* argv[]) {
+    int i, reset;
+
+    reset = argc > 1 && strcmp(argv[1], "-r") == 0;
+    if(argc > 2 || (argc == 2 && !reset)) {
+        printf(2, "usage: syslat [-r]\n");
+        exit();
+    }
+
+    if(sysstat(&st, reset) < 0) {
+        printf(2, "syslat: failed\n");
+        exit();
+    }
+
+    printf(1, "syscall\t\tcalls\tp50\tp99\t(cycles)\n");
+    for(i = 1; i < NSYSCALL; i++) {
+        if(st.count[i] == 0)
+            continue;
+        if(i < NSYSNAMES && sysnames[i])
+            printf(1, "%s", sysnames[i]);
+        else
+            printf(1, "%d", i);
+        if(i >= NSYSNAMES || sysnames[i] == 0 || strlen(sysnames[i]) < 8)
+            printf(1, "\t");
+        printf(1, "\t%d", st.count[i]);
+        printpct(st.hist[i], st.count[i], 50);
+        printpct(st.hist[i], st.count[i], 99);
+        printf(1, "\n");
+    }
+    if(reset)
+        printf(1, "statistics reset\n");
+    exit();
+}
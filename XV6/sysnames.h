@@ -0,0 +1,60 @@
+// System call names, indexed by number.
+// Users must include syscall.h first.
+
+static char *sysnames[] = {
+    [SYS_fork] "fork",
+    [SYS_exit] "exit",
+    [SYS_wait] "wait",
+    [SYS_pipe] "pipe",
+    [SYS_read] "read",
+    [SYS_kill] "kill",
+    [SYS_exec] "exec",
+    [SYS_fstat] "fstat",
+    [SYS_chdir] "chdir",
+    [SYS_dup] "dup",
+    [SYS_getpid] "getpid",
+    [SYS_sbrk] "sbrk",
+    [SYS_sleep] "sleep",
+    [SYS_uptime] "uptime",
+    [SYS_open] "open",
+    [SYS_write] "write",
+    [SYS_mknod] "mknod",
+    [SYS_unlink] "unlink",
+    [SYS_link] "link",
+    [SYS_mkdir] "mkdir",
+    [SYS_close] "close",
+    [SYS_next_palindrome] "next_palindrome",
+    [SYS_set_sleep_syscall] "set_sleep_syscall",
+    [SYS_get_system_time] "get_system_time",
+    [SYS_make_user] "make_user",
+    [SYS_login] "login",
+    [SYS_logout] "logout",
+    [SYS_logs] "logs",
+    [SYS_diff] "diff",
+    [SYS_create_realtime_process] "create_realtime_process",
+    [SYS_change_process_queue] "change_process_queue",
+    [SYS_print_process_info] "print_process_info",
+    [SYS_barber_sleep] "barber_sleep",
+    [SYS_customer_arrive] "customer_arrive",
+    [SYS_cut_hair] "cut_hair",
+    [SYS_init_rw_lock] "init_rw_lock",
+    [SYS_get_rw_pattern] "get_rw_pattern",
+    [SYS_critical_section] "critical_section",
+    [SYS_list_programs] "list_programs",
+    [SYS_fsstat] "fsstat",
+    [SYS_settrace] "settrace",
+    [SYS_traceread] "traceread",
+    [SYS_sysstat] "sysstat",
+    [SYS_profstart] "profstart",
+    [SYS_profstop] "profstop",
+    [SYS_profread] "profread",
+    [SYS_lockstat] "lockstat",
+    [SYS_lockbench] "lockbench",
+    [SYS_rwbench] "rwbench",
+    [SYS_uartstat] "uartstat",
+    [SYS_lseek] "lseek",
+    [SYS_auditread] "auditread",
+    [SYS_setsid] "setsid",
+};
+
+#define NSYSNAMES (sizeof(sysnames)/sizeof(sysnames[0]))
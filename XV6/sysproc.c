@@ -6,6 +6,12 @@
 #include "memlayout.h"
 #include "mmu.h"
 #include "proc.h"
+#include "spinlock.h"
+#include "rwlock.h"
+#include "trace.h"
+#include "prof.h"
+#include "lockstat.h"
+#include "uart.h"
 
 
 int
@@ -97,9 +103,12 @@ sys_uptime(void)
 int
 sys_next_palindrome(void)
 {
-  int in_num=myproc()->tf->ebx;
-  next_palindrome(in_num);
-  return 0;
+  char *num, *buf;
+  int n;
+
+  if(argstr(0, &num) < 0 || argint(2, &n) < 0 || argptr(1, &buf, n) < 0)
+    return -1;
+  return next_palindrome(num, buf, n);
 }
 
 int 
@@ -133,24 +142,27 @@ sys_logout(void){
   return logout();
 }
 
+int
+sys_setsid(void)
+{
+  return setsid();
+}
+
 int
 sys_logs(void){
   return logs();
 }
 
-int 
+int
 sys_diff(void)
 {
-  // get data from trap's stack
-  char* file1;
-  char* file2;
-  if(argstr(0, &file1)<0)
-    return -1;
-  if(argstr(1, &file2)<0)
-    return -1;
+  char *file1, *file2, *buf;
+  int n;
 
-  int result = diff(file1, file2);
-  return result;
+  if(argstr(0, &file1) < 0 || argstr(1, &file2) < 0 ||
+     argint(3, &n) < 0 || argptr(2, &buf, n) < 0)
+    return -1;
+  return diff(file1, file2, buf, n);
 }
 
 int
@@ -261,4 +273,149 @@ int
 sys_list_programs(void)
 {
   return 0;
-}
\ No newline at end of file
+}
+
+// Set the system call trace mask of process pid,
+// or the audit mask for logged-in users if pid is 0.
+int
+sys_settrace(void)
+{
+  int pid;
+  uint *mask;
+
+  if(argint(0, &pid) < 0 || argptr(1, (void*)&mask, TRACE_MASKWORDS*sizeof(uint)) < 0)
+    return -1;
+  if(pid == 0){
+    setauditmask(mask);
+    return 0;
+  }
+  return settrace(pid, mask);
+}
+
+// n is at most what the rings hold, which also keeps
+// n*sizeof(*buf) from overflowing.
+int
+sys_traceread(void)
+{
+  struct tracerec *buf;
+  uint *lost;
+  int n;
+
+  if(argint(1, &n) < 0 || n < 0 || n > NTRACE*NCPU ||
+     argptr(0, (void*)&buf, n*sizeof(*buf)) < 0 ||
+     argptr(2, (void*)&lost, sizeof(*lost)) < 0)
+    return -1;
+  return traceread(buf, n, lost);
+}
+
+int
+sys_auditread(void)
+{
+  struct tracerec *buf;
+  uint *lost;
+  int n;
+
+  if(argint(1, &n) < 0 || n < 0 || n > NTRACE*NCPU ||
+     argptr(0, (void*)&buf, n*sizeof(*buf)) < 0 ||
+     argptr(2, (void*)&lost, sizeof(*lost)) < 0)
+    return -1;
+  return auditread(buf, n, lost);
+}
+
+// Copy out the system call statistics, clearing them if
+// the second argument is non-zero.
+int
+sys_sysstat(void)
+{
+  struct sysstat *st;
+  int reset;
+
+  if(argptr(0, (void*)&st, sizeof(*st)) < 0 || argint(1, &reset) < 0)
+    return -1;
+  sysstatread(st, reset);
+  return 0;
+}
+
+// Start sampling every n'th timer tick on each CPU.
+int
+sys_profstart(void)
+{
+  int period;
+
+  if(argint(0, &period) < 0)
+    return -1;
+  return profstart(period);
+}
+
+int
+sys_profstop(void)
+{
+  profstop();
+  return 0;
+}
+
+int
+sys_profread(void)
+{
+  struct profsample *buf;
+  uint *lost;
+  int n;
+
+  if(argint(1, &n) < 0 || n < 0 || n > NPROF*NCPU ||
+     argptr(0, (void*)&buf, n*sizeof(*buf)) < 0 ||
+     argptr(2, (void*)&lost, sizeof(*lost)) < 0)
+    return -1;
+  return profread(buf, n, lost);
+}
+
+int
+sys_lockstat(void)
+{
+  struct lockinfo *buf;
+  int cmd, n;
+
+  if(argint(0, &cmd) < 0 || argint(2, &n) < 0 || n < 0 || n > NLOCKCLASS ||
+     argptr(1, (void*)&buf, n*sizeof(*buf)) < 0)
+    return -1;
+  return lockstat(cmd, buf, n);
+}
+
+int
+sys_uartstat(void)
+{
+  struct uartstat *st;
+
+  if(argptr(0, (void*)&st, sizeof(*st)) < 0)
+    return -1;
+  uartstat(st);
+  return 0;
+}
+
+int
+sys_lockbench(void)
+{
+  int ticketed, start, end;
+
+  if(argint(0, &ticketed) < 0 || argint(1, &start) < 0 || argint(2, &end) < 0)
+    return -1;
+  if(end < start || end - start > 1000)
+    return -1;
+  return lockbench(ticketed, start, end);
+}
+
+int
+sys_rwbench(void)
+{
+  int policy, writepct, start, end;
+  int *counts;
+
+  if(argint(0, &policy) < 0 || argint(1, &writepct) < 0 ||
+     argint(2, &start) < 0 || argint(3, &end) < 0 ||
+     argptr(4, (void*)&counts, 2*sizeof(counts[0])) < 0)
+    return -1;
+  if(policy < RW_READERS || policy > RW_PHASEFAIR || writepct < 0 || writepct > 100)
+    return -1;
+  if(end < start || end - start > 1000)
+    return -1;
+  return rwbench(policy, writepct, start, end, counts);
+}
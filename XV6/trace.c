@@ -0,0 +1,320 @@
+// System call tracing and statistics.
+//
+// syscall() records a struct tracerec for each call whose number
+// is set in the calling process's p->tracemask, or in the global
+// audit mask while the process's session is logged in.  Records go into a ring
+// owned by the CPU that made the call, so recording takes no lock:
+// the owning CPU is the only writer and writes with interrupts off.
+// A ring keeps the last NTRACE records; older ones are overwritten.
+//
+// Readers (traceread, tracedump) copy a record and then check that
+// the writer has not lapped it in the meantime, so they never see
+// a torn record.  tracelock only serializes readers with each other.
+//
+// auditread feeds the audit daemon (auditd), which appends audited
+// records to a file.  It keeps its own per-CPU cursors and polls
+// once a tick, so the system call path never wakes anyone up.
+//
+// syscall() also times every call with the TSC and counts it in
+// a per-CPU log2 latency histogram (struct sysstat), read with
+// the sysstat system call.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "x86.h"
+#include "proc.h"
+#include "spinlock.h"
+#include "syscall.h"
+#include "trace.h"
+#include "user_mgmt.h"
+
+struct tracering {
+  struct tracerec rec[NTRACE];
+  volatile uint head;  // Number of records ever written
+  uint tail;           // Next record for traceread()
+};
+
+static struct tracering rings[NCPU];
+static struct spinlock tracelock;
+
+// Per-CPU system call counts and latency histograms,
+// updated by the CPU a call finishes on.
+static struct sysstat stats[NCPU];
+
+// System calls recorded for logged-in users.
+static uint auditmask[TRACE_MASKWORDS];
+static uint auditcur[NCPU];  // Next record for auditread()
+static int auditpid;         // auditread's caller, not itself audited
+
+static int audited[] = {
+  SYS_make_user,
+  SYS_login,
+  SYS_logout,
+  SYS_next_palindrome,
+  SYS_mkdir,
+  SYS_open,
+  SYS_unlink,
+  SYS_exec,
+  SYS_fork,
+  SYS_kill,
+  SYS_wait,
+  SYS_chdir,
+  SYS_getpid,
+  SYS_sbrk,
+  SYS_sleep,
+  SYS_uptime,
+  SYS_logs,
+};
+
+#define MASKBIT(m, n) ((m)[(n)/32] & (1 << ((n)%32)))
+
+void
+traceinit(void)
+{
+  int i;
+
+  initlock(&tracelock, "trace");
+  for(i = 0; i < NELEM(audited); i++)
+    auditmask[audited[i]/32] |= 1 << (audited[i]%32);
+}
+
+// Might syscall() need to record call num by p?
+// Cheap enough to test on every system call.
+int
+tracewanted(struct proc *p, int num)
+{
+  return MASKBIT(p->tracemask, num) || MASKBIT(auditmask, num);
+}
+
+// Start a record of call num by the current process.
+// The arguments must be fetched before the call runs,
+// since exec replaces the user stack they live on.
+void
+tracebegin(struct tracerec *r, int num)
+{
+  int i;
+
+  r->num = num;
+  for(i = 0; i < TRACE_NARGS; i++)
+    if(argint(i, &r->args[i]) < 0)
+      r->args[i] = 0;
+}
+
+// Finish r for a call that ran from TSC start to end and
+// append it to this CPU's ring, unless the call was only
+// audited and no user is logged in (checked after the call
+// so that login itself is recorded) or it was made by init or
+// the audit daemon.
+void
+traceend(struct tracerec *r, uint64 start, uint64 end, int ret)
+{
+  struct proc *p = myproc();
+  struct tracering *t;
+
+  r->tsc = start;
+  r->cycles = end - start;
+  r->ret = ret;
+  r->pid = p->pid;
+  r->uid = current_uid();
+  if(!MASKBIT(p->tracemask, r->num) &&
+     (r->uid < 0 || p->pid == 1 || p->pid == auditpid || p->name[0] == '\0'))
+    return;
+
+  pushcli();
+  t = &rings[cpuid()];
+  t->rec[t->head % NTRACE] = *r;
+  __sync_synchronize();
+  t->head++;
+  popcli();
+}
+
+// Copy record i of ring t into *r.  Return 0 if the writer
+// has overwritten it, or may have been overwriting it
+// while we copied.
+static int
+tracefetch(struct tracering *t, uint i, struct tracerec *r)
+{
+  if(t->head - i > NTRACE)
+    return 0;
+  *r = t->rec[i % NTRACE];
+  __sync_synchronize();
+  return t->head - i < NTRACE;
+}
+
+// Merge the rings in time-stamp order.  cur[c] is the next
+// record to look at in CPU c's ring.  Store the oldest
+// unread record in *r and return 1, or return 0 if every
+// ring is exhausted.  Records lost to the writer are
+// counted in *lost.  Caller must hold tracelock.
+static int
+tracenext(uint *cur, struct tracerec *r, uint *lost)
+{
+  struct tracering *t;
+  struct tracerec rec;
+  int c, best;
+
+  best = -1;
+  for(c = 0; c < ncpu; c++){
+    t = &rings[c];
+    if(t->head - cur[c] > NTRACE){
+      *lost += t->head - cur[c] - NTRACE;
+      cur[c] = t->head - NTRACE;
+    }
+    if(cur[c] == t->head)
+      continue;
+    if(!tracefetch(t, cur[c], &rec)){
+      (*lost)++;
+      cur[c]++;
+      c--;
+      continue;
+    }
+    if(best < 0 || rec.tsc < r->tsc){
+      best = c;
+      *r = rec;
+    }
+  }
+  if(best < 0)
+    return 0;
+  cur[best]++;
+  return 1;
+}
+
+// Move up to n unread records into buf, oldest first.
+// Set *lost to the number of unread records that were
+// overwritten before we got to them.  Return the number moved.
+int
+traceread(struct tracerec *buf, int n, uint *lost)
+{
+  uint cur[NCPU];
+  int c, i;
+
+  acquire(&tracelock);
+  for(c = 0; c < ncpu; c++)
+    cur[c] = rings[c].tail;
+  *lost = 0;
+  for(i = 0; i < n && tracenext(cur, &buf[i], lost); i++)
+    ;
+  for(c = 0; c < ncpu; c++)
+    rings[c].tail = cur[c];
+  release(&tracelock);
+  return i;
+}
+
+// Move up to n audited calls made by logged-in users into buf,
+// oldest first, waiting for at least one.  Set *lost to the
+// number overwritten before they could be read.  Meant for a
+// single reader, the audit daemon.
+int
+auditread(struct tracerec *buf, int n, uint *lost)
+{
+  struct proc *p = myproc();
+  struct tracerec r;
+  int i;
+
+  for(;;){
+    acquire(&tracelock);
+    auditpid = p->pid;
+    *lost = 0;
+    i = 0;
+    while(i < n && tracenext(auditcur, &r, lost))
+      if(MASKBIT(auditmask, r.num) && r.uid >= 0)
+        buf[i++] = r;
+    release(&tracelock);
+    if(i > 0 || *lost > 0 || n == 0)
+      return i;
+    acquire(&tickslock);
+    if(p->killed){
+      release(&tickslock);
+      return -1;
+    }
+    sleep(&ticks, &tickslock);
+    release(&tickslock);
+  }
+}
+
+// Print the audited system calls still in the rings made by
+// user uid, or by any logged-in user if uid is -1.
+// Does not consume them.
+void
+tracedump(int uid)
+{
+  uint cur[NCPU], lost;
+  struct tracerec r;
+  int c;
+
+  acquire(&tracelock);
+  for(c = 0; c < ncpu; c++)
+    cur[c] = rings[c].head < NTRACE ? 0 : rings[c].head - NTRACE;
+  lost = 0;
+  while(tracenext(cur, &r, &lost)){
+    if(!MASKBIT(auditmask, r.num) || r.uid < 0)
+      continue;
+    if(uid >= 0 && r.uid != uid)
+      continue;
+    cprintf("%d\n", r.num);
+  }
+  release(&tracelock);
+}
+
+// Replace the set of system calls audited for logged-in users.
+void
+setauditmask(uint *mask)
+{
+  int i;
+
+  acquire(&tracelock);
+  for(i = 0; i < TRACE_MASKWORDS; i++)
+    auditmask[i] = mask[i];
+  release(&tracelock);
+}
+
+// Account a call to num that took cycles TSC cycles.
+void
+sysstatadd(int num, uint64 cycles)
+{
+  struct sysstat *st;
+  uint hi, lo;
+  int b;
+
+  // b = floor(log2(cycles)), clamped to the last bucket.
+  hi = cycles >> 32;
+  lo = cycles;
+  if(hi != 0)
+    b = NLATBUCKET - 1;
+  else
+    for(b = 0; b < NLATBUCKET - 1 && (lo >> (b + 1)) != 0; b++)
+      ;
+
+  pushcli();
+  st = &stats[cpuid()];
+  st->count[num]++;
+  st->cycles[num] += cycles;
+  st->hist[num][b]++;
+  popcli();
+}
+
+// Sum the per-CPU statistics into *out.
+// If reset is set, also clear them.
+// Calls finishing on other CPUs meanwhile may be missed.
+void
+sysstatread(struct sysstat *out, int reset)
+{
+  struct sysstat *st;
+  int c, i, b;
+
+  memset(out, 0, sizeof(*out));
+  for(c = 0; c < ncpu; c++){
+    st = &stats[c];
+    for(i = 0; i < NSYSCALL; i++){
+      out->count[i] += st->count[i];
+      out->cycles[i] += st->cycles[i];
+      for(b = 0; b < NLATBUCKET; b++)
+        out->hist[i][b] += st->hist[i][b];
+    }
+    if(reset)
+      memset(st, 0, sizeof(*st));
+  }
+}
@@ -0,0 +1,49 @@
+// System call trace records and latency statistics.
+// Both the kernel and user programs use this header file.
+// Users must include param.h first.
+
+#define TRACE_NARGS 3
+#define TRACE_MASKWORDS (NSYSCALL/32)
+
+// One traced system call, as returned by traceread().
+struct tracerec {
+  uint64 tsc;               // Time-stamp counter at entry
+  uint cycles;              // TSC cycles spent in the call
+  int pid;                  // Calling process
+  int uid;                  // Logged-in user, or -1
+  int num;                  // System call number
+  int args[TRACE_NARGS];    // First argument words
+  int ret;                  // Return value
+};
+
+// One record of the audit log files, which auditd appends to
+// from auditread() and logs reads.  time is AUDITTIME() of the
+// struct rtcdate when auditd wrote it; packed like this, times
+// compare in time order.  A record with num AUDIT_LOST stands
+// for ret records that were overwritten before auditd read them.
+struct auditrec {
+  uint time;
+  int uid;
+  int ret;
+  ushort pid;
+  ushort num;
+};
+
+#define AUDITLOG    "/auditlog"
+#define AUDITOLD    "/auditlog.0"   // AUDITLOG, once it reaches AUDITMAX
+#define AUDITMAX    (64*1024)
+#define AUDIT_LOST  0xffff
+
+#define AUDITTIME(r) (((r)->year - 2000) << 26 | (r)->month << 22 | \
+                      (r)->day << 17 | (r)->hour << 12 | (r)->minute << 6 | (r)->second)
+
+#define NLATBUCKET 32
+
+// System call counts and latencies, as returned by sysstat().
+// hist[n][b] counts calls to n that took [2^b, 2^(b+1)) TSC
+// cycles; the last bucket also holds anything slower.
+struct sysstat {
+  uint count[NSYSCALL];
+  uint64 cycles[NSYSCALL];  // Total cycles
+  uint hist[NSYSCALL][NLATBUCKET];
+};
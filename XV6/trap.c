@@ -23,7 +23,7 @@ tvinit(void)
     SETGATE(idt[i], 0, SEG_KCODE<<3, vectors[i], 0);
   SETGATE(idt[T_SYSCALL], 1, SEG_KCODE<<3, vectors[T_SYSCALL], DPL_USER);
 
-  initlock(&tickslock, "time");
+  initticketlock(&tickslock, "time");
 }
 
 void
@@ -58,6 +58,7 @@ trap(struct trapframe *tf)
       wakeup(&ticks);
       release(&tickslock);
     }
+    proftick(tf);
     lapiceoi();
     break;
   case T_IRQ0 + IRQ_IDE:
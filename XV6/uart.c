@@ -11,11 +11,28 @@
 #include "mmu.h"
 #include "proc.h"
 #include "x86.h"
+#include "uart.h"
 
 #define COM1    0x3f8
+#define TXBUF   512
 
 static int uart;    // is there a uart?
 
+// Output waits in tx.buf and is sent by uartsend(), which
+// runs after a writer adds bytes and on each transmitter-empty
+// interrupt, so writers don't spin while the line drains.
+static struct {
+  struct spinlock lock;
+  char buf[TXBUF];
+  uint r;         // Next byte to send
+  uint w;         // Next free slot
+  uint sent;      // Bytes sent
+  uint overruns;  // Writes that found the ring full
+  int waiting;    // Is a writer sleeping for space?
+} tx;
+
+static void uartsend(void);
+
 void
 uartinit(void)
 {
@@ -30,7 +47,9 @@ uartinit(void)
   outb(COM1+1, 0);
   outb(COM1+3, 0x03);    // Lock divisor, 8 data bits.
   outb(COM1+4, 0);
-  outb(COM1+1, 0x01);    // Enable receive interrupts.
+  outb(COM1+1, 0x03);    // Enable receive and transmit-empty interrupts.
+
+  initlock(&tx.lock, "uart");
 
   // If status is 0xFF, no serial port.
   if(inb(COM1+5) == 0xFF)
@@ -48,6 +67,24 @@ uartinit(void)
     uartputc(*p);
 }
 
+// Send buffered bytes while the transmitter will take them.
+// Caller must hold tx.lock.
+static void
+uartsend(void)
+{
+  while(tx.r != tx.w && (inb(COM1+5) & 0x20)){
+    outb(COM1+0, tx.buf[tx.r++ % TXBUF]);
+    tx.sent++;
+  }
+  if(tx.waiting && tx.w - tx.r <= TXBUF/2){
+    tx.waiting = 0;
+    wakeup(&tx.r);
+  }
+}
+
+// Queue c for sending.  Callers may hold spinlocks (cprintf
+// holds cons.lock), so if the ring is full this cannot sleep:
+// it pushes out a byte by polling, as uartputc always used to.
 void
 uartputc(int c)
 {
@@ -55,9 +92,75 @@ uartputc(int c)
 
   if(!uart)
     return;
-  for(i = 0; i < 128 && !(inb(COM1+5) & 0x20); i++)
-    microdelay(10);
-  outb(COM1+0, c);
+  acquire(&tx.lock);
+  if(tx.w - tx.r == TXBUF){
+    tx.overruns++;
+    for(i = 0; i < 128 && !(inb(COM1+5) & 0x20); i++)
+      microdelay(10);
+    outb(COM1+0, tx.buf[tx.r++ % TXBUF]);
+    tx.sent++;
+  }
+  tx.buf[tx.w++ % TXBUF] = c;
+  uartsend();
+  release(&tx.lock);
+}
+
+// Queue as many of the n bytes as the ring has room for and
+// return how many that was.  Never sleeps and leaves sending
+// to uartstart, so callers may hold spinlocks (consolewrite
+// holds cons.lock, to keep the screen and the line in step).
+int
+uartqueue(char *buf, int n)
+{
+  int i;
+
+  if(!uart)
+    return n;
+  acquire(&tx.lock);
+  for(i = 0; i < n && tx.w - tx.r < TXBUF; i++)
+    tx.buf[tx.w++ % TXBUF] = buf[i];
+  if(i < n)
+    tx.overruns++;
+  release(&tx.lock);
+  return i;
+}
+
+// Start sending queued bytes; the transmit interrupt sends
+// the rest.
+void
+uartstart(void)
+{
+  if(!uart)
+    return;
+  acquire(&tx.lock);
+  uartsend();
+  release(&tx.lock);
+}
+
+// Sleep until the ring has room.
+// Must be called from process context without spinlocks held.
+void
+uartwait(void)
+{
+  if(!uart)
+    return;
+  acquire(&tx.lock);
+  uartsend();
+  while(tx.w - tx.r == TXBUF){
+    tx.waiting = 1;
+    sleep(&tx.r, &tx.lock);
+  }
+  release(&tx.lock);
+}
+
+void
+uartstat(struct uartstat *st)
+{
+  acquire(&tx.lock);
+  st->sent = tx.sent;
+  st->overruns = tx.overruns;
+  st->queued = tx.w - tx.r;
+  release(&tx.lock);
 }
 
 static int
@@ -73,5 +176,13 @@ uartgetc(void)
 void
 uartintr(void)
 {
+  // Reading the interrupt identification register
+  // acknowledges a transmit-empty interrupt.
+  inb(COM1+2);
+  if(uart){
+    acquire(&tx.lock);
+    uartsend();
+    release(&tx.lock);
+  }
   consoleintr(uartgetc);
 }
@@ -0,0 +1,9 @@
+// Serial port statistics.
+// Both the kernel and user programs use this header file.
+
+// Output statistics, filled in by uartstat().
+struct uartstat {
+  uint sent;      // Bytes sent
+  uint overruns;  // Writes that found the transmit ring full
+  uint queued;    // Bytes waiting to be sent
+};
@@ -0,0 +1,15 @@
+#include "types.h"
+#include "uart.h"
+#include "user.h"
+
+int main(int argc, char* argv[]) {
+    struct uartstat us;
+
+    if(uartstat(&us) < 0) {
+        printf(2, "uartstat: failed\n");
+        exit();
+    }
+    printf(1, "uart: %d bytes sent, %d queued, %d overruns\n",
+           us.sent, us.queued, us.overruns);
+    exit();
+}
@@ -4,6 +4,12 @@
 #include "user.h"
 #include "x86.h"
 
+// As in the kernel's string.c, the string and memory routines
+// work a word at a time where they can.
+#define ONES        0x01010101
+#define HASZERO(x)  (((x) - ONES) & ~(x) & 0x80808080)
+#define COALIGNED(p, q)  ((((uint)(p) ^ (uint)(q)) & 3) == 0)
+
 char*
 strcpy(char *s, const char *t)
 {
@@ -26,26 +32,101 @@ strcmp(const char *p, const char *q)
 uint
 strlen(const char *s)
 {
-  int n;
+  const char *p;
+  const uint *w;
 
-  for(n = 0; s[n]; n++)
+  for(p = s; (uint)p & 3; p++)
+    if(*p == 0)
+      return p - s;
+  for(w = (const uint*)p; !HASZERO(*w); w++)
     ;
-  return n;
+  for(p = (const char*)w; *p; p++)
+    ;
+  return p - s;
 }
 
 void*
 memset(void *dst, int c, uint n)
 {
-  stosb(dst, c, n);
+  char *d;
+  uint k;
+
+  d = dst;
+  c &= 0xFF;
+  if(n >= 8){
+    k = -(uint)d & 3;
+    stosb(d, c, k);
+    d += k;
+    n -= k;
+    stosl(d, (uint)c * ONES, n / 4);
+    d += n & ~3;
+    n &= 3;
+  }
+  stosb(d, c, n);
   return dst;
 }
 
 char*
 strchr(const char *s, char c)
 {
-  for(; *s; s++)
+  const uint *w;
+  uint x, m;
+
+  // Check for the NUL first, so that c == 0 never matches.
+  for(; (uint)s & 3; s++){
+    if(*s == 0)
+      return 0;
     if(*s == c)
       return (char*)s;
+  }
+  // Stop at the word holding c or the terminating NUL.
+  m = (uchar)c * ONES;
+  for(w = (const uint*)s; x = *w, !HASZERO(x) && !HASZERO(x ^ m); w++)
+    ;
+  for(s = (const char*)w; *s; s++)
+    if(*s == c)
+      return (char*)s;
+  return 0;
+}
+
+void*
+memchr(const void *v, int c, uint n)
+{
+  const uchar *p;
+  const uint *w;
+  uint m;
+
+  p = v;
+  c &= 0xFF;
+  for(; n > 0 && ((uint)p & 3); n--, p++)
+    if(*p == c)
+      return (void*)p;
+  m = (uint)c * ONES;
+  for(w = (const uint*)p; n >= 4 && !HASZERO(*w ^ m); n -= 4)
+    w++;
+  for(p = (const uchar*)w; n > 0; n--, p++)
+    if(*p == c)
+      return (void*)p;
+  return 0;
+}
+
+int
+memcmp(const void *v1, const void *v2, uint n)
+{
+  const uchar *s1, *s2;
+
+  s1 = v1;
+  s2 = v2;
+  if(COALIGNED(s1, s2)){
+    for(; n > 0 && ((uint)s1 & 3); n--, s1++, s2++)
+      if(*s1 != *s2)
+        return *s1 - *s2;
+    for(; n >= 4 && *(uint*)s1 == *(uint*)s2; n -= 4)
+      s1 += 4, s2 += 4;
+  }
+  for(; n > 0; n--, s1++, s2++)
+    if(*s1 != *s2)
+      return *s1 - *s2;
   return 0;
 }
 
@@ -97,10 +178,103 @@ memmove(void *vdst, const void *vsrc, int n)
 {
   char *dst;
   const char *src;
+  int k;
 
   dst = vdst;
   src = vsrc;
-  while(n-- > 0)
-    *dst++ = *src++;
+  if(n <= 0)
+    return vdst;
+  if(src < dst && src + n > dst){
+    dst += n;
+    src += n;
+    if(COALIGNED(src, dst) && n >= 8){
+      for(; (uint)dst & 3; n--)
+        *--dst = *--src;
+      for(; n >= 4; n -= 4){
+        src -= 4;
+        dst -= 4;
+        *(uint*)dst = *(uint*)src;
+      }
+    }
+    while(n-- > 0)
+      *--dst = *--src;
+    return vdst;
+  }
+  if(COALIGNED(src, dst) && n >= 8){
+    k = -(uint)dst & 3;
+    movsb(dst, src, k);
+    dst += k;
+    src += k;
+    n -= k;
+    movsl(dst, src, n / 4);
+    dst += n & ~3;
+    src += n & ~3;
+    n &= 3;
+  }
+  movsb(dst, src, n);
   return vdst;
 }
+
+// Buffered output (printf.c) sets stdiohook so that these
+// calls flush it first: fd's buffer before write or close
+// (which also discards the buffer), everything (fd -1) before
+// read, fork, exec and exit, so that output is neither lost,
+// duplicated nor reordered.  printf.c sets it the first time
+// a stream is used, so it stays 0 in programs that never
+// printf.
+void (*stdiohook)(int fd, int closing);
+
+int _fork(void);
+int _exit(void) __attribute__((noreturn));
+int _read(int, void*, int);
+int _write(int, const void*, int);
+int _close(int);
+int _exec(char*, char**);
+
+int
+fork(void)
+{
+  if(stdiohook)
+    stdiohook(-1, 0);
+  return _fork();
+}
+
+int
+exit(void)
+{
+  if(stdiohook)
+    stdiohook(-1, 0);
+  _exit();
+}
+
+int
+read(int fd, void *buf, int n)
+{
+  if(stdiohook)
+    stdiohook(-1, 0);
+  return _read(fd, buf, n);
+}
+
+int
+write(int fd, const void *buf, int n)
+{
+  if(stdiohook)
+    stdiohook(fd, 0);
+  return _write(fd, buf, n);
+}
+
+int
+close(int fd)
+{
+  if(stdiohook)
+    stdiohook(fd, 1);
+  return _close(fd);
+}
+
+int
+exec(char *path, char **argv)
+{
+  if(stdiohook)
+    stdiohook(-1, 0);
+  return _exec(path, argv);
+}
@@ -3,8 +3,20 @@
 #include "user.h"
 #include "param.h"
 
-// Memory allocator by Kernighan and Ritchie,
-// The C programming Language, 2nd ed.  Section 8.7.
+// Small requests (up to MAXSMALL bytes) are served from
+// segregated free lists, one per power-of-two size class, so
+// malloc and free of a small block are a list push or pop.
+// A class's list is refilled by carving a CHUNK-byte piece of
+// fresh sbrk memory into blocks of that class; small blocks are
+// never coalesced or returned to the large allocator.
+//
+// Larger requests use the first-fit, coalescing free list by
+// Kernighan and Ritchie, The C programming Language, 2nd ed.,
+// Section 8.7, which now only ever sees large blocks.
+//
+// Every block starts with a Header.  An allocated small block
+// keeps its class in s.size; a large block keeps its size in
+// units, which is always at least LARGEMIN > NCLASS.
 
 typedef long Align;
 
@@ -18,15 +30,29 @@ union header {
 
 typedef union header Header;
 
-static Header base;
+#define MINSHIFT  4                     // Smallest class: 16-byte blocks
+#define NCLASS    8                     // 16 .. 2048-byte blocks
+#define MAXSMALL  ((1 << (MINSHIFT + NCLASS - 1)) - sizeof(Header))
+#define CHUNK     4096                  // Bytes carved per refill
+#define LARGEMIN  ((MAXSMALL + sizeof(Header) - 1)/sizeof(Header) + 2)
+
+static Header *classes[NCLASS];         // Free small blocks
+static Header base;                     // Large free list
 static Header *freep;
 
-void
-free(void *ap)
+static struct {
+  uint inuse[NCLASS];                   // Small blocks allocated
+  uint free[NCLASS];                    // Small blocks on the lists
+  uint largeinuse;                      // Large blocks allocated
+  uint largebytes;                      // ... and their size
+  uint core;                            // Bytes obtained from sbrk
+} stats;
+
+static void
+largefree(Header *bp)
 {
-  Header *bp, *p;
+  Header *p;
 
-  bp = (Header*)ap - 1;
   for(p = freep; !(bp > p && bp < p->s.ptr); p = p->s.ptr)
     if(p >= p->s.ptr && (bp > p || bp < p->s.ptr))
       break;
@@ -43,6 +69,28 @@ free(void *ap)
   freep = p;
 }
 
+void
+free(void *ap)
+{
+  Header *bp;
+  uint c;
+
+  if(ap == 0)
+    return;
+  bp = (Header*)ap - 1;
+  c = bp->s.size;
+  if(c < NCLASS){
+    bp->s.ptr = classes[c];
+    classes[c] = bp;
+    stats.inuse[c]--;
+    stats.free[c]++;
+    return;
+  }
+  stats.largeinuse--;
+  stats.largebytes -= c * sizeof(Header);
+  largefree(bp);
+}
+
 static Header*
 morecore(uint nu)
 {
@@ -54,26 +102,30 @@ morecore(uint nu)
   p = sbrk(nu * sizeof(Header));
   if(p == (char*)-1)
     return 0;
+  stats.core += nu * sizeof(Header);
   hp = (Header*)p;
   hp->s.size = nu;
-  free((void*)(hp + 1));
+  largefree(hp);
   return freep;
 }
 
-void*
-malloc(uint nbytes)
+static void*
+largealloc(uint nbytes)
 {
   Header *p, *prevp;
   uint nunits;
 
   nunits = (nbytes + sizeof(Header) - 1)/sizeof(Header) + 1;
+  if(nunits < LARGEMIN)
+    nunits = LARGEMIN;
   if((prevp = freep) == 0){
     base.s.ptr = freep = prevp = &base;
     base.s.size = 0;
   }
   for(p = prevp->s.ptr; ; prevp = p, p = p->s.ptr){
     if(p->s.size >= nunits){
-      if(p->s.size == nunits)
+      // Don't leave a remainder too small to tell from a class.
+      if(p->s.size < nunits + LARGEMIN)
         prevp->s.ptr = p->s.ptr;
       else {
         p->s.size -= nunits;
@@ -81,6 +133,8 @@ malloc(uint nbytes)
         p->s.size = nunits;
       }
       freep = prevp;
+      stats.largeinuse++;
+      stats.largebytes += p->s.size * sizeof(Header);
       return (void*)(p + 1);
     }
     if(p == freep)
@@ -88,3 +142,58 @@ malloc(uint nbytes)
         return 0;
   }
 }
+
+// Carve a chunk of fresh memory into class c blocks.
+static int
+refill(uint c)
+{
+  char *p;
+  uint size, i;
+  Header *hp;
+
+  if((p = sbrk(CHUNK)) == (char*)-1)
+    return -1;
+  stats.core += CHUNK;
+  size = 1 << (MINSHIFT + c);
+  for(i = 0; i + size <= CHUNK; i += size){
+    hp = (Header*)(p + i);
+    hp->s.ptr = classes[c];
+    classes[c] = hp;
+    stats.free[c]++;
+  }
+  return 0;
+}
+
+void*
+malloc(uint nbytes)
+{
+  Header *p;
+  uint c;
+
+  if(nbytes > MAXSMALL)
+    return largealloc(nbytes);
+  for(c = 0; (1 << (MINSHIFT + c)) < nbytes + sizeof(Header); c++)
+    ;
+  if(classes[c] == 0 && refill(c) < 0)
+    return 0;
+  p = classes[c];
+  classes[c] = p->s.ptr;
+  p->s.size = c;
+  stats.free[c]--;
+  stats.inuse[c]++;
+  return (void*)(p + 1);
+}
+
+void
+malloc_stats(void)
+{
+  uint c;
+
+  printf(1, "class\tinuse\tfree\n");
+  for(c = 0; c < NCLASS; c++)
+    if(stats.inuse[c] || stats.free[c])
+      printf(1, "%d\t%d\t%d\n", 1 << (MINSHIFT + c),
+             stats.inuse[c], stats.free[c]);
+  printf(1, "large\t%d\t%d bytes\n", stats.largeinuse, stats.largebytes);
+  printf(1, "sbrk\t%d bytes\n", stats.core);
+}
@@ -1,4 +1,10 @@
 struct stat;
+struct fsstat;
+struct uartstat;
+struct tracerec;
+struct sysstat;
+struct profsample;
+struct lockinfo;
 struct rtcdate;
 
 // system calls
@@ -23,7 +29,7 @@ int getpid(void);
 char* sbrk(int);
 int sleep(int);
 int uptime(void);
-void next_palindrome(int num);
+int next_palindrome(const char*, char*, int);
 int set_sleep_syscall(int tick);
 int get_system_time(struct rtcdate*);
 
@@ -31,7 +37,7 @@ int make_user(int user_id, const char* password);
 int login(int user_id, const char* password);
 int logout();
 int logs();
-int diff(const char* file1, const char* file2);
+int diff(const char*, const char*, char*, int);
 
 
 int create_realtime_process(int);
@@ -50,12 +56,36 @@ char* strcpy(char*, const char*);
 void *memmove(void*, const void*, int);
 char* strchr(const char*, char c);
 int strcmp(const char*, const char*);
+// setvbuf modes
+#define _IONBF 1  // Unbuffered
+#define _IOLBF 2  // Flush on newline
+#define _IOFBF 3  // Flush when full
+
 void printf(int, const char*, ...);
+void fflush(int);
+int setvbuf(int, int);
 char* gets(char*, int max);
 uint strlen(const char*);
 void* memset(void*, int, uint);
+void* memchr(const void*, int, uint);
+int memcmp(const void*, const void*, uint);
 void* malloc(uint);
 void free(void*);
+void malloc_stats(void);
 int atoi(const char*);
 
-int list_programs(void);
\ No newline at end of file
+int list_programs(void);
+int fsstat(struct fsstat*);
+int settrace(int, uint*);
+int traceread(struct tracerec*, int, uint*);
+int sysstat(struct sysstat*, int);
+int profstart(int);
+int profstop(void);
+int profread(struct profsample*, int, uint*);
+int lockstat(int, struct lockinfo*, int);
+int lockbench(int, uint, uint);
+int rwbench(int, int, uint, uint, int*);
+int uartstat(struct uartstat*);
+int lseek(int, int, int);
+int auditread(struct tracerec*, int, uint*);
+int setsid(void);
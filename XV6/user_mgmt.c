@@ -10,62 +10,82 @@
 
 // Errors
 char * USER_MAX_ERR = "User maximum number reached\n";
-char * LOG_MAX_ERR = "Log maximum number reached\n";
 char * UNIQUE_ERR = "The username is duplicate\n";
-char * ALREADY_LOGEDIN = "Some one is already logged in\n";
+char * ALREADY_LOGEDIN = "This session is already logged in\n";
 char * USER_NOT_FOUND = "User not found or wrong password!\n";
 char * NOT_LOGIN = "Not logged in yet\n";
 char * NO_USER = "There are no users\n";
+char * NO_SESSION = "No session to log in\n";
 
 struct user_list users;
 
-// cur_user
 struct spinlock login_lock;
-struct user *curr_user = 0;
+struct session sessions[NSESSION];
+
+// login_lock protects users and sessions.  A process's
+// credentials are its session's uid, which the system call path
+// reads without the lock (see current_uid).
+void init_users(void) {
+  initlock(&login_lock, "login");
+  for (int i = 0; i < NUSERHASH; i++)
+    users.hash[i] = -1;
+}
 
+static int user_hash(int user_id) {
+  return (uint)user_id % NUSERHASH;
+}
 
 int add_user(int user_id, const char *password) {
+  acquire(&login_lock);
   if (users.size >= MAX_USERS)
   {
+    release(&login_lock);
     cprintf(USER_MAX_ERR);
     return FAILURE;
   }
 
   if(!is_user_id_unique(user_id)){
+    release(&login_lock);
     cprintf(UNIQUE_ERR);
     return FAILURE;
   }
 
-  struct user *u = &users.data[users.size++];
+  int i = users.size++;
+  struct user *u = &users.data[i];
   u->used = 1;
   u->user_id = user_id;
   safestrcpy(u->password, password, PASSWORD_LEN);
-  u->is_logged_in = 0;
-  u->log_count = 0;
+  u->next = users.hash[user_hash(user_id)];
+  users.hash[user_hash(user_id)] = i;
+  release(&login_lock);
 
   return SUCCESS;
 }
 
 
+// Log the caller's session in, so that it and every other
+// process in the session act as user_id.  Any number of sessions
+// may be logged in at once, as the same or different users.
 int login_user(int user_id, const char *password) {
-    acquire(&login_lock);
+    struct session *s = myproc()->session;
 
-    
-    if (curr_user->is_logged_in == 1) { //some one is already logged in
+    acquire(&login_lock);
+    if (s == 0) {
+        release(&login_lock);
+        cprintf(NO_SESSION);
+        return FAILURE;
+    }
+    if (s->uid >= 0) {
         release(&login_lock);
         cprintf(ALREADY_LOGEDIN);
         return FAILURE;
     }
-    
-    for (int i = 0; i < users.size; i++) {
-        if (users.data[i].user_id == user_id &&
-            strncmp(users.data[i].password, password, PASSWORD_LEN) == 0) {     
-                users.data[i].is_logged_in = 1;
-                curr_user = &users.data[i];
 
-            release(&login_lock);
-            return SUCCESS;
-        }
+    struct user *u = find_user(user_id);
+    if (u && strncmp(u->password, password, PASSWORD_LEN) == 0) {
+        s->uid = user_id;
+        release(&login_lock);
+        return SUCCESS;
     }
     release(&login_lock);
     cprintf(USER_NOT_FOUND);
@@ -74,70 +94,91 @@ int login_user(int user_id, const char *password) {
 
 
 int logout_user() {
-    acquire(&login_lock);
+    struct session *s = myproc()->session;
 
-    if (curr_user == 0 || curr_user->is_logged_in == 0) {
+    acquire(&login_lock);
+    if (s == 0 || s->uid < 0) {
         release(&login_lock);
         cprintf(NOT_LOGIN);
         return FAILURE;
     }
-    curr_user->is_logged_in = 0;
-    curr_user = 0;
+    s->uid = -1;
 
     release(&login_lock);
     return SUCCESS;
 }
 
-void log_syscall(int syscall_no) {
-    acquire(&login_lock);
+// The system calls themselves are recorded by trace.c.
+void get_user_logs(){
+    int uid = current_uid();
+
+    if(uid >= 0)
+        cprintf("Recent logs for user (%d) : \n" , uid);
+    else
+        cprintf("Recent logs for all users : \n");
+    cprintf("=====================================\n");
+    tracedump(uid);
+    cprintf("=====================================\n");
+}
 
-    if (curr_user && curr_user->is_logged_in == 1)
-    {
-        if(curr_user->log_count >= MAX_USER_LOGS) // reset logs
-        {
-            cprintf(LOG_MAX_ERR);
-            curr_user->log_count = 0;
+// Id of the user the current process acts as, or -1.  Called
+// on the system call path, so it takes no lock: the session
+// cannot be freed while the process is in it, and uid is a
+// single word.
+int current_uid(void) {
+    struct session *s = myproc()->session;
+
+    return s ? s->uid : -1;
+}
+
+// A new session, not logged in, with one reference.
+struct session* session_alloc(void) {
+    struct session *s;
+
+    acquire(&login_lock);
+    for (s = sessions; s < &sessions[NSESSION]; s++) {
+        if (s->ref == 0) {
+            s->ref = 1;
+            s->uid = -1;
             release(&login_lock);
-            return;
+            return s;
         }
-        // cprintf("Added : (%d)\n" , syscall_no);
-        curr_user->syscall_log[curr_user->log_count++] = syscall_no;
     }
     release(&login_lock);
+    return 0;
 }
 
-void get_user_logs(){
+void session_dup(struct session *s) {
+    if (s == 0)
+        return;
     acquire(&login_lock);
+    s->ref++;
+    release(&login_lock);
+}
 
-    if(curr_user && curr_user->is_logged_in == 1){
-        cprintf("Recent logs for user (%d) : \n" , curr_user->user_id);
-        cprintf("=====================================\n");
-        for(int i = 0 ; i < curr_user->log_count ; i++){
-            cprintf("%d\n" , curr_user->syscall_log[i]);
-        }
-        cprintf("=====================================\n");
-    }
-    else { 
-        cprintf("Recent logs for all users : \n");
-        cprintf("=====================================\n");
-        for (int i = 0 ; i < users.size ; i++){
-            for(int j = 0 ; j < users.data[i].log_count ; j++) {
-                cprintf("%d\n" , users.data[i].syscall_log[j]);
-            }
-        }
-        cprintf("=====================================\n");
-    }
+// Drop a reference; the last one logs the session out.
+void session_put(struct session *s) {
+    if (s == 0)
+        return;
+    acquire(&login_lock);
+    if (--s->ref == 0)
+        s->uid = -1;
     release(&login_lock);
 }
 
 
 //helper functions
-int is_user_id_unique(int user_id){
-    for(int i = 0; i < users.size; i++) {
+// Caller must hold login_lock.
+struct user* find_user(int user_id){
+    for(int i = users.hash[user_hash(user_id)]; i >= 0; i = users.data[i].next) {
         if (users.data[i].user_id == user_id) {
-            return 0; 
+            return &users.data[i];
         }
     }
-    return 1;
+    return 0;
+}
+
+int is_user_id_unique(int user_id){
+    return find_user(user_id) == 0;
 }
 
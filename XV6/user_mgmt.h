@@ -3,8 +3,9 @@
 
 
 #define MAX_USERS 64
+#define NSESSION NPROC
+#define NUSERHASH 32
 #define PASSWORD_LEN 16
-#define MAX_USER_LOGS 64
 
 #define SUCCESS 0
 #define FAILURE -1
@@ -13,25 +14,37 @@ struct user {
   int used;
   int user_id;
   char password[PASSWORD_LEN];
-  int is_logged_in;
-
-  int syscall_log[MAX_USER_LOGS];
-  int log_count;
+  int next;                // Next in hash chain, or -1
 };
 
+// Users are never removed, so data[0..size) are in use, each
+// on the hash chain starting at hash[user_id % NUSERHASH].
 struct user_list {
   struct user data[MAX_USERS];
   int size;
+  int hash[NUSERHASH];
+};
+
+// A login session: a setsid() caller and the processes it
+// forks, which share its credentials.  Free when ref is 0.
+struct session {
+  int ref;
+  int uid;                 // Logged-in user, or -1
 };
 
+void init_users(void);
 int add_user(int user_id, const char *password);
 int login_user(int user_id, const char *password);
 int logout_user();
-void log_syscall(int syscall_num);
 void get_user_logs();
+int current_uid(void);
+struct session* session_alloc(void);
+void session_dup(struct session *s);
+void session_put(struct session *s);
 
 // helper functions
 int is_user_id_unique(int user_id);
+struct user* find_user(int user_id);
 
 
 #endif
@@ -5,6 +5,10 @@
 #include "fs.h"
 #include "fcntl.h"
 #include "syscall.h"
+#include "trace.h"
+#include "prof.h"
+#include "lockstat.h"
+#include "uart.h"
 #include "traps.h"
 #include "memlayout.h"
 
@@ -1347,7 +1351,8 @@ iref(void)
 
   printf(1, "empty file name\n");
 
-  // the 50 is NINODE
+  // the 50 was NINODE; the disk has too few inodes to outgrow
+  // the current inode cache this way
   for(i = 0; i < 50 + 1; i++){
     if(mkdir("irefd") != 0){
       printf(1, "mkdir irefd failed\n");
@@ -1737,6 +1742,1171 @@ void argptest()
   printf(1, "arg test passed\n");
 }
 
+static void
+hdname(char *nm, int i)
+{
+  nm[0] = '/';
+  nm[1] = 'h';
+  nm[2] = 'd';
+  nm[3] = '0' + i / 10;
+  nm[4] = '0' + i % 10;
+  nm[5] = 0;
+}
+
+// Open nm and check that it holds the int want.
+static void
+hdcheck(char *nm, int want)
+{
+  int fd, got;
+
+  if((fd = open(nm, 0)) < 0){
+    printf(1, "hashdir: open %s failed\n", nm);
+    exit();
+  }
+  if(read(fd, &got, sizeof(got)) != sizeof(got) || got != want){
+    printf(1, "hashdir: %s holds the wrong file\n", nm);
+    exit();
+  }
+  close(fd);
+}
+
+// The root is a hashed directory (mkfs sets I_HASHDIR): create,
+// unlink, relink and recreate names in it, and check that every
+// lookup still finds the right file.
+void
+hashdirtest(void)
+{
+  char nm[8], nm2[8];
+  int i, fd;
+  struct stat st;
+
+  printf(1, "hashdir test\n");
+
+  for(i = 0; i < 64; i++){
+    hdname(nm, i);
+    fd = open(nm, O_CREATE|O_RDWR);
+    if(fd < 0 || write(fd, &i, sizeof(i)) != sizeof(i)){
+      printf(1, "hashdir: create %s failed\n", nm);
+      exit();
+    }
+    close(fd);
+  }
+  for(i = 0; i < 64; i += 2){
+    hdname(nm, i);
+    if(unlink(nm) < 0){
+      printf(1, "hashdir: unlink %s failed\n", nm);
+      exit();
+    }
+  }
+  for(i = 0; i < 64; i++){
+    hdname(nm, i);
+    if(i % 2 == 0){
+      if(open(nm, 0) >= 0){
+        printf(1, "hashdir: unlinked %s is still there\n", nm);
+        exit();
+      }
+    } else
+      hdcheck(nm, i);
+  }
+
+  // Give each odd file its even neighbour's name as well, then
+  // unlink the odd names and create them afresh.
+  for(i = 0; i < 64; i += 2){
+    hdname(nm, i + 1);
+    hdname(nm2, i);
+    if(link(nm, nm2) < 0){
+      printf(1, "hashdir: link %s %s failed\n", nm, nm2);
+      exit();
+    }
+  }
+  for(i = 1; i < 64; i += 2){
+    hdname(nm, i);
+    unlink(nm);
+    fd = open(nm, O_CREATE|O_RDWR);
+    if(fd < 0 || fstat(fd, &st) < 0 || st.size != 0){
+      printf(1, "hashdir: recreate %s failed\n", nm);
+      exit();
+    }
+    close(fd);
+  }
+  for(i = 0; i < 64; i += 2){
+    hdname(nm, i);
+    hdcheck(nm, i + 1);
+  }
+
+  for(i = 0; i < 64; i++){
+    hdname(nm, i);
+    if(unlink(nm) < 0){
+      printf(1, "hashdir: unlink %s failed\n", nm);
+      exit();
+    }
+  }
+  printf(1, "hashdir ok\n");
+}
+
+// Name lookups go through the dentry cache: repeated lookups of a
+// missing name must hit a cached negative entry, and creating,
+// unlinking and removing directories must never leave a stale one.
+void
+dcachetest(void)
+{
+  struct fsstat st0, st1;
+  struct stat st;
+  int i, fd;
+
+  printf(1, "dcache test\n");
+
+  unlink("dcdir/sub/f");
+  unlink("dcdir/sub");
+  unlink("dcdir");
+  unlink("dcfile");
+
+  open("dcnothere", 0);
+  if(fsstat(&st0) < 0){
+    printf(1, "dcache: fsstat failed\n");
+    exit();
+  }
+  for(i = 0; i < 10; i++){
+    if(open("dcnothere", 0) >= 0){
+      printf(1, "dcache: open of a missing file succeeded\n");
+      exit();
+    }
+  }
+  fsstat(&st1);
+  if(st1.dcache_neghits - st0.dcache_neghits < 10 ||
+     st1.dcache_hits - st0.dcache_hits < 10){
+    printf(1, "dcache: missing-name lookups not cached\n");
+    exit();
+  }
+
+  // A cached negative entry must not hide a new file, and a cached
+  // positive one must not outlive the unlink.
+  for(i = 0; i < 3; i++){
+    if(open("dcfile", 0) >= 0){
+      printf(1, "dcache: dcfile present before create\n");
+      exit();
+    }
+    fd = open("dcfile", O_CREATE|O_RDWR);
+    if(fd < 0){
+      printf(1, "dcache: create dcfile failed\n");
+      exit();
+    }
+    close(fd);
+    if((fd = open("dcfile", 0)) < 0){
+      printf(1, "dcache: dcfile missing after create\n");
+      exit();
+    }
+    close(fd);
+    if(unlink("dcfile") < 0){
+      printf(1, "dcache: unlink dcfile failed\n");
+      exit();
+    }
+  }
+
+  // Remove a nested directory and rebuild it: lookups through the
+  // old path must see the new, empty directory.
+  if(mkdir("dcdir") < 0 || mkdir("dcdir/sub") < 0){
+    printf(1, "dcache: mkdir failed\n");
+    exit();
+  }
+  fd = open("dcdir/sub/f", O_CREATE|O_RDWR);
+  if(fd < 0){
+    printf(1, "dcache: create dcdir/sub/f failed\n");
+    exit();
+  }
+  close(fd);
+  if(unlink("dcdir/sub") == 0){
+    printf(1, "dcache: unlinked a non-empty directory\n");
+    exit();
+  }
+  if(unlink("dcdir/sub/f") < 0 || unlink("dcdir/sub") < 0){
+    printf(1, "dcache: unlink dcdir/sub failed\n");
+    exit();
+  }
+  if(open("dcdir/sub/f", 0) >= 0 || stat("dcdir/sub", &st) >= 0){
+    printf(1, "dcache: removed directory still reachable\n");
+    exit();
+  }
+  if(mkdir("dcdir/sub") < 0){
+    printf(1, "dcache: mkdir dcdir/sub again failed\n");
+    exit();
+  }
+  if(open("dcdir/sub/f", 0) >= 0){
+    printf(1, "dcache: new directory not empty\n");
+    exit();
+  }
+  if(unlink("dcdir/sub") < 0 || unlink("dcdir") < 0){
+    printf(1, "dcache: cleanup failed\n");
+    exit();
+  }
+  printf(1, "dcache ok\n");
+}
+
+// settrace() on ourselves must make traceread() return a record
+// of each traced call, and settrace() on a missing pid must fail.
+void
+tracetest(void)
+{
+  static struct tracerec recs[64];
+  uint mask[TRACE_MASKWORDS], lost;
+  int i, n, pid, found;
+
+  printf(1, "trace test\n");
+
+  pid = getpid();
+  memset(mask, 0, sizeof(mask));
+  if(settrace(1000000, mask) == 0){
+    printf(1, "trace: settrace of a missing pid succeeded\n");
+    exit();
+  }
+  while(traceread(recs, 64, &lost) > 0)
+    ;
+
+  mask[SYS_getpid/32] |= 1 << (SYS_getpid%32);
+  if(settrace(pid, mask) < 0){
+    printf(1, "trace: settrace failed\n");
+    exit();
+  }
+  for(i = 0; i < 5; i++)
+    getpid();
+  memset(mask, 0, sizeof(mask));
+  settrace(pid, mask);
+
+  found = 0;
+  while((n = traceread(recs, 64, &lost)) > 0){
+    for(i = 0; i < n; i++)
+      if(recs[i].pid == pid && recs[i].num == SYS_getpid && recs[i].ret == pid)
+        found++;
+  }
+  if(found != 5){
+    printf(1, "trace: found %d of 5 getpid records\n", found);
+    exit();
+  }
+  printf(1, "trace ok\n");
+}
+
+// sysstat() must count each system call, with its latency
+// in exactly one histogram bucket.
+void
+sysstattest(void)
+{
+  static struct sysstat st0, st1;
+  uint n;
+  int i;
+
+  printf(1, "sysstat test\n");
+
+  if(sysstat(&st0, 0) < 0){
+    printf(1, "sysstat: sysstat failed\n");
+    exit();
+  }
+  for(i = 0; i < 10; i++)
+    getpid();
+  sysstat(&st1, 0);
+  if(st1.count[SYS_getpid] - st0.count[SYS_getpid] < 10 ||
+     st1.cycles[SYS_getpid] <= st0.cycles[SYS_getpid]){
+    printf(1, "sysstat: getpid calls not counted\n");
+    exit();
+  }
+  n = 0;
+  for(i = 0; i < NLATBUCKET; i++)
+    n += st1.hist[SYS_getpid][i];
+  if(n != st1.count[SYS_getpid]){
+    printf(1, "sysstat: histogram holds %d calls, not %d\n", n, st1.count[SYS_getpid]);
+    exit();
+  }
+  printf(1, "sysstat ok\n");
+}
+
+// A process spinning in user space for a few ticks with the
+// profiler running must show up in profread() as user samples.
+void
+proftest(void)
+{
+  static struct profsample s[128];
+  uint lost;
+  int i, n, pid, found, t;
+
+  printf(1, "prof test\n");
+
+  if(profstart(0) == 0){
+    printf(1, "prof: profstart(0) succeeded\n");
+    exit();
+  }
+  pid = getpid();
+  if(profstart(1) < 0){
+    printf(1, "prof: profstart failed\n");
+    exit();
+  }
+  t = uptime();
+  while(uptime() < t + 5)
+    for(i = 0; i < 100000; i++)
+      __sync_synchronize();
+  profstop();
+
+  found = 0;
+  while((n = profread(s, 128, &lost)) > 0){
+    for(i = 0; i < n; i++){
+      if(s[i].pid == pid && s[i].user && s[i].eip >= KERNBASE){
+        printf(1, "prof: user sample at kernel address %x\n", s[i].eip);
+        exit();
+      }
+      if(s[i].pid == pid && s[i].user)
+        found++;
+    }
+  }
+  if(found == 0){
+    printf(1, "prof: no user samples\n");
+    exit();
+  }
+  printf(1, "prof ok\n");
+}
+
+// With lockstat on, file system calls must count acquisitions
+// of both spin locks and sleep locks.
+void
+lockstattest(void)
+{
+  static struct lockinfo li[NLOCKCLASS];
+  int i, n, fd, spin, sleep;
+
+  printf(1, "lockstat test\n");
+
+  if(lockstat(-1, li, 0) == 0){
+    printf(1, "lockstat: bad command succeeded\n");
+    exit();
+  }
+  if(lockstat(LOCKSTAT_RESET, li, 0) < 0 || lockstat(LOCKSTAT_ON, li, 0) < 0){
+    printf(1, "lockstat: reset/on failed\n");
+    exit();
+  }
+  for(i = 0; i < 5; i++){
+    fd = open("lsfile", O_CREATE|O_RDWR);
+    if(fd < 0 || write(fd, "x", 1) != 1){
+      printf(1, "lockstat: write lsfile failed\n");
+      exit();
+    }
+    close(fd);
+    unlink("lsfile");
+  }
+  lockstat(LOCKSTAT_OFF, li, 0);
+
+  n = lockstat(LOCKSTAT_READ, li, NLOCKCLASS);
+  if(n <= 0){
+    printf(1, "lockstat: read returned %d\n", n);
+    exit();
+  }
+  spin = sleep = 0;
+  for(i = 0; i < n; i++){
+    if(li[i].acquire == 0)
+      continue;
+    if(li[i].contended > li[i].acquire){
+      printf(1, "lockstat: %s contended more than acquired\n", li[i].name);
+      exit();
+    }
+    if(li[i].sleep)
+      sleep++;
+    else
+      spin++;
+  }
+  if(spin == 0 || sleep == 0){
+    printf(1, "lockstat: %d spin and %d sleep classes acquired\n", spin, sleep);
+    exit();
+  }
+  printf(1, "lockstat ok\n");
+}
+
+// Two processes contending for the plain and the ticket
+// benchmark lock must each get it some of the time.
+void
+lockbenchtest(void)
+{
+  int fd[2], i, t, c, start;
+
+  printf(1, "lockbench test\n");
+
+  start = uptime();
+  if(lockbench(1, start, start + 1001) != -1){
+    printf(1, "lockbench: over-long run accepted\n");
+    exit();
+  }
+  for(t = 0; t < 2; t++){
+    if(pipe(fd) < 0){
+      printf(1, "lockbench: pipe failed\n");
+      exit();
+    }
+    start = uptime() + 2;
+    for(i = 0; i < 2; i++){
+      if(fork() == 0){
+        close(fd[0]);
+        c = lockbench(t, start, start + 3);
+        write(fd[1], &c, sizeof(c));
+        exit();
+      }
+    }
+    close(fd[1]);
+    for(i = 0; i < 2; i++){
+      if(read(fd[0], &c, sizeof(c)) != sizeof(c) || c <= 0){
+        printf(1, "lockbench: %s lock never acquired\n", t ? "ticket" : "plain");
+        exit();
+      }
+    }
+    close(fd[0]);
+    wait();
+    wait();
+  }
+  printf(1, "lockbench ok\n");
+}
+
+// Readers and writers under each rwlock policy must all make
+// progress; an unknown policy must be refused.
+void
+rwbenchtest(void)
+{
+  int fd[2], i, p, start, counts[2];
+
+  printf(1, "rwbench test\n");
+
+  start = uptime();
+  if(rwbench(3, 10, start, start + 1, counts) != -1 ||
+     rwbench(0, -1, start, start + 1, counts) != -1 ||
+     rwbench(0, 101, start, start + 1, counts) != -1){
+    printf(1, "rwbench: bad policy or write percentage accepted\n");
+    exit();
+  }
+  for(p = 0; p < 3; p++){
+    if(pipe(fd) < 0){
+      printf(1, "rwbench: pipe failed\n");
+      exit();
+    }
+    start = uptime() + 2;
+    for(i = 0; i < 2; i++){
+      if(fork() == 0){
+        close(fd[0]);
+        if(rwbench(p, 20, start, start + 3, counts) < 0)
+          counts[0] = counts[1] = 0;
+        write(fd[1], counts, sizeof(counts));
+        exit();
+      }
+    }
+    close(fd[1]);
+    for(i = 0; i < 2; i++){
+      if(read(fd[0], counts, sizeof(counts)) != sizeof(counts) ||
+         counts[0] + counts[1] <= 0){
+        printf(1, "rwbench: policy %d made no progress\n", p);
+        exit();
+      }
+    }
+    close(fd[0]);
+    wait();
+    wait();
+  }
+  printf(1, "rwbench ok\n");
+}
+
+// Console output is copied to the serial port through a transmit
+// ring: a line written to the console must be queued there, and
+// the transmit interrupt must drain the ring.
+void
+uartstattest(void)
+{
+  struct uartstat st0, st1;
+  char *msg = "uartstat test\n";
+  int i;
+
+  if(uartstat(&st0) < 0){
+    printf(1, "uartstat: uartstat failed\n");
+    exit();
+  }
+  if(st0.sent == 0 && st0.queued == 0){
+    printf(1, "uartstat test: no serial port\n");
+    return;
+  }
+  write(1, msg, strlen(msg));
+  uartstat(&st1);
+  if(st1.sent + st1.queued - (st0.sent + st0.queued) < strlen(msg)){
+    printf(1, "uartstat: console line not queued\n");
+    exit();
+  }
+  for(i = 0; i < 100 && st1.queued != 0; i++){
+    sleep(1);
+    uartstat(&st1);
+  }
+  if(st1.queued != 0){
+    printf(1, "uartstat: transmit ring not drained\n");
+    exit();
+  }
+  printf(1, "uartstat ok\n");
+}
+
+// printf to a file is fully buffered: nothing reaches the file
+// until a flush, and fork, exit, write and close must flush so
+// that output is neither lost, duplicated nor reordered.
+void
+stdiotest(void)
+{
+  struct stat st;
+  char got[16];
+  int fd, n;
+
+  printf(1, "stdio test\n");
+
+  unlink("stdiofile");
+  fd = open("stdiofile", O_CREATE|O_RDWR);
+  if(fd < 0){
+    printf(1, "stdio: create stdiofile failed\n");
+    exit();
+  }
+  printf(fd, "a%d", 1);
+  if(fstat(fd, &st) < 0 || st.size != 0){
+    printf(1, "stdio: file output not buffered\n");
+    exit();
+  }
+  if(fork() == 0){
+    printf(fd, "c");
+    exit();
+  }
+  wait();
+  printf(fd, "d");
+  write(fd, "e", 1);
+  printf(fd, "f");
+  close(fd);
+
+  fd = open("stdiofile", 0);
+  n = read(fd, got, sizeof(got));
+  close(fd);
+  if(n != 6 || memcmp(got, "a1cdef", 6) != 0){
+    printf(1, "stdio: stdiofile holds the wrong bytes\n");
+    exit();
+  }
+
+  unlink("stdiofile");
+  fd = open("stdiofile", O_CREATE|O_RDWR);
+  if(setvbuf(fd, _IONBF) < 0){
+    printf(1, "stdio: setvbuf failed\n");
+    exit();
+  }
+  printf(fd, "x");
+  if(fstat(fd, &st) < 0 || st.size != 1 || setvbuf(fd, 0) != -1){
+    printf(1, "stdio: setvbuf did not take effect\n");
+    exit();
+  }
+  close(fd);
+  unlink("stdiofile");
+  printf(1, "stdio ok\n");
+}
+
+#define NMBLOCK 200
+
+static char *mblock[NMBLOCK];
+static uint mbsize[NMBLOCK];
+static uint mbseed = 1;
+
+// Allocate block i, sized around the largest small class for
+// the first few and at random, small or large, after that, and
+// fill it with its own pattern.
+static void
+mballoc(int i)
+{
+  mbseed = mbseed * 1103515245 + 12345;
+  if(i < 16)
+    mbsize[i] = 2030 + i;
+  else
+    mbsize[i] = 1 + (mbseed >> 16) % (i % 4 == 0 ? 8000 : 600);
+  if((mblock[i] = malloc(mbsize[i])) == 0){
+    printf(1, "malloc: malloc(%d) failed\n", mbsize[i]);
+    exit();
+  }
+  memset(mblock[i], i, mbsize[i]);
+}
+
+static void
+mbcheck(void)
+{
+  int i, j;
+
+  for(i = 0; i < NMBLOCK; i++){
+    for(j = 0; j < mbsize[i]; j++){
+      if(mblock[i][j] != (char)i){
+        printf(1, "malloc: block %d overwritten\n", i);
+        exit();
+      }
+    }
+  }
+}
+
+// Allocate blocks of many sizes, free and reallocate half of
+// them at a time, and check that no block overlaps another.
+void
+malloctest(void)
+{
+  int i;
+
+  printf(1, "malloc test\n");
+
+  for(i = 0; i < NMBLOCK; i++)
+    mballoc(i);
+  mbcheck();
+  for(i = 0; i < NMBLOCK; i += 2)
+    free(mblock[i]);
+  for(i = 0; i < NMBLOCK; i += 2)
+    mballoc(i);
+  mbcheck();
+  for(i = 1; i < NMBLOCK; i += 2)
+    free(mblock[i]);
+  for(i = 1; i < NMBLOCK; i += 2)
+    mballoc(i);
+  mbcheck();
+  for(i = 0; i < NMBLOCK; i++)
+    free(mblock[i]);
+  printf(1, "malloc ok\n");
+}
+
+static void
+difffile(char *path, char *s)
+{
+  int fd;
+
+  unlink(path);
+  fd = open(path, O_CREATE|O_RDWR);
+  if(fd < 0 || write(fd, s, strlen(s)) != strlen(s)){
+    printf(1, "diff: write %s failed\n", path);
+    exit();
+  }
+  close(fd);
+}
+
+// diff() must print the changed lines as -U0 hunks, return the
+// full length however small the buffer, and return 0 for equal
+// files.
+void
+difftest(void)
+{
+  char *want = "@@ -2 +2 @@\n-b\n+x\n@@ -4,0 +5 @@\n+e\n";
+  char out[64];
+  int n;
+
+  printf(1, "diff test\n");
+
+  difffile("diffa", "a\nb\nc\nd\n");
+  difffile("diffb", "a\nx\nc\nd\ne");
+  memset(out, 0, sizeof(out));
+  n = diff("diffa", "diffb", out, sizeof(out));
+  if(n != strlen(want) || strcmp(out, want) != 0){
+    printf(1, "diff: wrong output (%d bytes): %s\n", n, out);
+    exit();
+  }
+  memset(out, 0, sizeof(out));
+  if(diff("diffa", "diffb", out, 5) != n || strlen(out) != 5 ||
+     memcmp(out, want, 5) != 0){
+    printf(1, "diff: short buffer mishandled\n");
+    exit();
+  }
+  if(diff("diffa", "diffa", out, sizeof(out)) != 0){
+    printf(1, "diff: file differs from itself\n");
+    exit();
+  }
+  if(diff("diffa", "diffnothere", out, sizeof(out)) != -1){
+    printf(1, "diff: missing file not reported\n");
+    exit();
+  }
+  unlink("diffa");
+  unlink("diffb");
+  printf(1, "diff ok\n");
+}
+
+#define STRBUF 128
+
+static char sa[STRBUF], sb[STRBUF], sref[STRBUF];
+static int strlens[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63 };
+
+static void
+strfill(char *p, int seed)
+{
+  int i;
+
+  for(i = 0; i < STRBUF; i++)
+    p[i] = seed + i * 7 + 1;
+}
+
+static void
+strfail(char *what, int doff, int soff, int n)
+{
+  printf(1, "string: %s wrong at offsets %d/%d length %d\n", what, doff, soff, n);
+  exit();
+}
+
+// The string and memory routines in ulib.c work a word at a
+// time: check them against byte-at-a-time results for every
+// alignment of source and destination and for lengths around
+// word boundaries.  Writing and reading files at odd addresses
+// and lengths does the same for the kernel's memmove.
+void
+stringtest(void)
+{
+  int d, s, k, l, n, i, c, r, fd;
+
+  printf(1, "string test\n");
+
+  for(l = 0; l < sizeof(strlens)/sizeof(strlens[0]); l++){
+    n = strlens[l];
+    for(d = 0; d < 4; d++){
+      // memset
+      strfill(sa, d);
+      strfill(sref, d);
+      for(i = 0; i < n; i++)
+        sref[8+d+i] = 0xAB;
+      if(memset(sa+8+d, 0x1AB, n) != sa+8+d || memcmp(sa, sref, STRBUF) != 0)
+        strfail("memset", d, 0, n);
+
+      // strlen
+      memset(sa, 'x', STRBUF);
+      sa[8+d+n] = 0;
+      if(strlen(sa+8+d) != n)
+        strfail("strlen", d, 0, n);
+
+      // strchr, for a plain and a high-bit character
+      for(k = 0; k < n; k++){
+        sa[8+d+k] = 'y';
+        if(strchr(sa+8+d, 'y') != sa+8+d+k)
+          strfail("strchr", d, k, n);
+        sa[8+d+k] = 0xC8;
+        if(strchr(sa+8+d, 0xC8) != sa+8+d+k)
+          strfail("strchr", d, k, n);
+        sa[8+d+k] = 'x';
+      }
+      if(strchr(sa+8+d, 'y') != 0 || strchr(sa+8+d, 0) != 0)
+        strfail("strchr", d, n, n);
+
+      // memchr, which must not stop at a NUL
+      memset(sa, 0, STRBUF);
+      for(k = 0; k < n; k++){
+        sa[8+d+k] = 0xC8;
+        if(memchr(sa+8+d, 0xC8, n) != sa+8+d+k || memchr(sa+8+d, 0xC8, k) != 0)
+          strfail("memchr", d, k, n);
+        sa[8+d+k] = 0;
+      }
+
+      for(s = 0; s < 4; s++){
+        // memmove between separate buffers
+        strfill(sa, s);
+        strfill(sb, d + 100);
+        strfill(sref, d + 100);
+        for(i = 0; i < n; i++)
+          sref[8+d+i] = sa[8+s+i];
+        if(memmove(sb+8+d, sa+8+s, n) != sb+8+d || memcmp(sb, sref, STRBUF) != 0)
+          strfail("memmove", d, s, n);
+
+        // memcmp: equal, then differing at each position
+        if(memcmp(sb+8+d, sa+8+s, n) != 0)
+          strfail("memcmp", d, s, n);
+        for(k = 0; k < n; k++){
+          for(i = 0x01; i <= 0x80; i += 0x7F){
+            sb[8+d+k] ^= i;
+            c = (uchar)sb[8+d+k] - (uchar)sa[8+s+k];
+            r = memcmp(sb+8+d, sa+8+s, n);
+            if(r == 0 || (r < 0) != (c < 0) || memcmp(sb+8+d, sa+8+s, k) != 0)
+              strfail("memcmp", d, s, n);
+            sb[8+d+k] ^= i;
+          }
+        }
+
+        // memmove within one buffer, overlapping either way
+        for(k = -5; k <= 5; k++){
+          strfill(sa, k);
+          memmove(sref, sa, STRBUF);
+          for(i = 0; i < n; i++)
+            sb[i] = sa[16+s+k+i];
+          for(i = 0; i < n; i++)
+            sref[16+d+i] = sb[i];
+          if(memmove(sa+16+d, sa+16+s+k, n) != sa+16+d || memcmp(sa, sref, STRBUF) != 0)
+            strfail("overlapping memmove", d, s + k, n);
+        }
+
+        // The kernel's copies, through a file
+        strfill(sa, s);
+        strfill(sb, d);
+        memmove(sref, sb, STRBUF);
+        memmove(sref+8+d, sa+8+s, n);
+        unlink("strfile");
+        fd = open("strfile", O_CREATE|O_RDWR);
+        if(fd < 0 || write(fd, sa+8+s, n) != n){
+          printf(1, "string: write strfile failed\n");
+          exit();
+        }
+        close(fd);
+        fd = open("strfile", 0);
+        if(fd < 0 || read(fd, sb+8+d, n) != n || memcmp(sb, sref, STRBUF) != 0)
+          strfail("kernel memmove", d, s, n);
+        close(fd);
+      }
+    }
+  }
+  unlink("strfile");
+  printf(1, "string ok\n");
+}
+
+// next_palindrome() must return the smallest palindrome not less
+// than its argument, however many digits that has.
+void
+palindrometest(void)
+{
+  static char *cases[][2] = {
+    { "8", "8" },
+    { "10", "11" },
+    { "99", "99" },
+    { "123", "131" },
+    { "199", "202" },
+    { "809", "818" },
+    { "1299", "1331" },
+    { "1991", "1991" },
+    { "0009", "9" },
+    { "123456789012345678909876543210", "123456789012346643210987654321" },
+  };
+  char out[40];
+  int i;
+
+  printf(1, "palindrome test\n");
+
+  for(i = 0; i < sizeof(cases)/sizeof(cases[0]); i++){
+    if(next_palindrome(cases[i][0], out, sizeof(out)) != strlen(cases[i][1]) ||
+       strcmp(out, cases[i][1]) != 0){
+      printf(1, "palindrome: %s gave %s, not %s\n", cases[i][0], out, cases[i][1]);
+      exit();
+    }
+  }
+  if(next_palindrome("12a", out, sizeof(out)) != -1 ||
+     next_palindrome("", out, sizeof(out)) != -1 ||
+     next_palindrome("123", out, 3) != -1){
+    printf(1, "palindrome: bad argument accepted\n");
+    exit();
+  }
+  printf(1, "palindrome ok\n");
+}
+
+// lseek() must move a file's offset from the start, the current
+// offset or the end, refuse negative offsets, and fail on pipes.
+void
+lseektest(void)
+{
+  struct stat st;
+  char got[4];
+  int fd, p[2];
+
+  printf(1, "lseek test\n");
+
+  unlink("seekfile");
+  fd = open("seekfile", O_CREATE|O_RDWR);
+  if(fd < 0 || write(fd, "0123456789", 10) != 10){
+    printf(1, "lseek: write seekfile failed\n");
+    exit();
+  }
+  if(lseek(fd, 3, SEEK_SET) != 3 || read(fd, got, 2) != 2 || memcmp(got, "34", 2) != 0 ||
+     lseek(fd, 0, SEEK_CUR) != 5 || lseek(fd, -3, SEEK_CUR) != 2 ||
+     read(fd, got, 1) != 1 || got[0] != '2'){
+    printf(1, "lseek: SEEK_SET or SEEK_CUR failed\n");
+    exit();
+  }
+  if(lseek(fd, -2, SEEK_END) != 8 || read(fd, got, 4) != 2 || memcmp(got, "89", 2) != 0){
+    printf(1, "lseek: SEEK_END failed\n");
+    exit();
+  }
+  if(lseek(fd, -1, SEEK_SET) != -1 || lseek(fd, -11, SEEK_END) != -1 ||
+     lseek(fd, 0, 3) != -1 || lseek(fd, 0, SEEK_CUR) != 10){
+    printf(1, "lseek: bad offset accepted\n");
+    exit();
+  }
+  if(lseek(fd, 0, SEEK_END) != 10 || write(fd, "ab", 2) != 2 ||
+     lseek(fd, 0, SEEK_SET) != 0 || write(fd, "x", 1) != 1 ||
+     fstat(fd, &st) < 0 || st.size != 12){
+    printf(1, "lseek: write after lseek failed\n");
+    exit();
+  }
+  close(fd);
+
+  if(pipe(p) < 0){
+    printf(1, "lseek: pipe failed\n");
+    exit();
+  }
+  if(lseek(p[0], 0, SEEK_SET) != -1){
+    printf(1, "lseek: lseek on a pipe succeeded\n");
+    exit();
+  }
+  close(p[0]);
+  close(p[1]);
+  unlink("seekfile");
+  printf(1, "lseek ok\n");
+}
+
+#define AUDITUID 4747
+
+// Does the audit log file path hold a record of a call num by
+// pid as user uid?
+static int
+auditfound(char *path, int uid, int pid, int num)
+{
+  static struct auditrec r[64];
+  int fd, i, n, found;
+
+  if((fd = open(path, 0)) < 0)
+    return 0;
+  found = 0;
+  while(!found && (n = read(fd, r, sizeof(r))) > 0)
+    for(i = 0; i < n / sizeof(r[0]); i++)
+      if(r[i].uid == uid && r[i].pid == (ushort)pid && r[i].num == num)
+        found = 1;
+  close(fd);
+  return found;
+}
+
+// A call audited for a logged-in user must reach the audit log
+// that auditd writes.
+void
+audittest(void)
+{
+  struct tracerec rec;
+  uint lost;
+  int pid, i;
+
+  printf(1, "audit test\n");
+
+  if(auditread(&rec, -1, &lost) != -1){
+    printf(1, "audit: auditread of -1 records succeeded\n");
+    exit();
+  }
+  pid = fork();
+  if(pid < 0){
+    printf(1, "audit: fork failed\n");
+    exit();
+  }
+  if(pid == 0){
+    // A session of our own, so as not to log in the shell's.
+    setsid();
+    make_user(AUDITUID, "audit");
+    if(login(AUDITUID, "audit") < 0){
+      printf(1, "audit: login failed\n");
+      exit();
+    }
+    getpid();
+    logout();
+    exit();
+  }
+  wait();
+  for(i = 0; i < 100; i++){
+    if(auditfound(AUDITLOG, AUDITUID, pid, SYS_getpid) ||
+       auditfound(AUDITOLD, AUDITUID, pid, SYS_getpid))
+      break;
+    sleep(1);
+  }
+  if(i == 100){
+    printf(1, "audit: getpid by user %d not in %s\n", AUDITUID, AUDITLOG);
+    exit();
+  }
+  printf(1, "audit ok\n");
+}
+
+// Run the session checks in a child, since logging in would
+// otherwise log in the shell's session.  The child writes its
+// verdict to fd.
+static void
+sessionchild(int fd)
+{
+  int pid, p[2];
+  char c;
+
+  setsid();
+  make_user(AUDITUID, "audit");
+  if(login(AUDITUID, "audit") < 0 || login(AUDITUID, "audit") != -1){
+    write(fd, "1", 1);
+    exit();
+  }
+  if(pipe(p) < 0){
+    write(fd, "2", 1);
+    exit();
+  }
+  pid = fork();
+  if(pid == 0){
+    // Another session may log in as the same user meanwhile.
+    setsid();
+    c = login(AUDITUID, "audit") == 0 && logout() == 0 ? 'y' : '3';
+    write(p[1], &c, 1);
+    exit();
+  }
+  wait();
+  if(read(p[0], &c, 1) != 1 || c != 'y'){
+    write(fd, "3", 1);
+    exit();
+  }
+  pid = fork();
+  if(pid == 0){
+    // A child shares its parent's session, even to logging out.
+    c = logout() == 0 ? 'y' : '4';
+    write(p[1], &c, 1);
+    exit();
+  }
+  wait();
+  if(read(p[0], &c, 1) != 1 || c != 'y' || logout() != -1){
+    write(fd, "4", 1);
+    exit();
+  }
+  write(fd, "y", 1);
+  exit();
+}
+
+// Sessions are shared by fork and independent of each other.
+void
+sessiontest(void)
+{
+  int p[2];
+  char c;
+
+  printf(1, "session test\n");
+
+  if(pipe(p) < 0){
+    printf(1, "session: pipe failed\n");
+    exit();
+  }
+  if(fork() == 0){
+    close(p[0]);
+    sessionchild(p[1]);
+  }
+  close(p[1]);
+  c = '?';
+  if(read(p[0], &c, 1) != 1 || c != 'y'){
+    printf(1, "session: check %c failed\n", c);
+    exit();
+  }
+  close(p[0]);
+  wait();
+  printf(1, "session ok\n");
+}
+
+// stat() reports mtime, ctime and a generation count: a write
+// must advance the file's gen, link and unlink must advance the
+// directory's gen but leave the file's, and a new file must not
+// reuse an old one's (ino, gen).
+void
+stattest(void)
+{
+  struct stat st, dst;
+  uint gen, dgen, ino;
+  int fd;
+
+  printf(1, "stat test\n");
+
+  unlink("statfile");
+  unlink("statfile2");
+  fd = open("statfile", O_CREATE|O_RDWR);
+  if(fd < 0 || fstat(fd, &st) < 0){
+    printf(1, "stat: create statfile failed\n");
+    exit();
+  }
+  if(st.mtime == 0 || st.ctime == 0){
+    printf(1, "stat: new file has no times\n");
+    exit();
+  }
+  gen = st.gen;
+  if(write(fd, "abc", 3) != 3 || fstat(fd, &st) < 0 || st.gen == gen || st.mtime == 0){
+    printf(1, "stat: write did not change gen\n");
+    exit();
+  }
+  gen = st.gen;
+  ino = st.ino;
+
+  if(stat(".", &dst) < 0){
+    printf(1, "stat: stat . failed\n");
+    exit();
+  }
+  dgen = dst.gen;
+  if(link("statfile", "statfile2") < 0 || fstat(fd, &st) < 0 || stat(".", &dst) < 0){
+    printf(1, "stat: link failed\n");
+    exit();
+  }
+  if(st.nlink != 2 || st.gen != gen || dst.gen == dgen){
+    printf(1, "stat: link changed the wrong gens\n");
+    exit();
+  }
+  dgen = dst.gen;
+  if(unlink("statfile2") < 0 || fstat(fd, &st) < 0 || stat(".", &dst) < 0){
+    printf(1, "stat: unlink failed\n");
+    exit();
+  }
+  if(st.nlink != 1 || st.gen != gen || dst.gen == dgen){
+    printf(1, "stat: unlink changed the wrong gens\n");
+    exit();
+  }
+  close(fd);
+
+  unlink("statfile");
+  fd = open("statfile", O_CREATE|O_RDWR);
+  if(fd < 0 || fstat(fd, &st) < 0 || (st.ino == ino && st.gen <= gen)){
+    printf(1, "stat: new file reuses an old gen\n");
+    exit();
+  }
+  close(fd);
+  unlink("statfile");
+  printf(1, "stat ok\n");
+}
+
+// Lookups of a cached inode must count as icache hits, and
+// cycling through more files than the cache holds must recycle
+// entries without mixing up their contents.
+void
+icachetest(void)
+{
+  struct fsstat st0, st1;
+  struct stat st;
+  char nm[5];
+  int i, k, n, fd;
+
+  printf(1, "icache test\n");
+
+  fd = open("icfile", O_CREATE|O_RDWR);
+  if(fd < 0){
+    printf(1, "icache: create icfile failed\n");
+    exit();
+  }
+  fsstat(&st0);
+  for(i = 0; i < 10; i++)
+    stat("icfile", &st);
+  fsstat(&st1);
+  if(st1.icache_hits - st0.icache_hits < 10){
+    printf(1, "icache: cached inode not hit\n");
+    exit();
+  }
+  close(fd);
+  unlink("icfile");
+
+  nm[0] = 'i';
+  nm[4] = 0;
+  for(k = 0; k < 2; k++){
+    for(i = 0; i < NINODE + 20; i++){
+      nm[1] = '0' + i / 100;
+      nm[2] = '0' + i / 10 % 10;
+      nm[3] = '0' + i % 10;
+      fd = open(nm, k == 0 ? O_CREATE|O_RDWR : O_RDONLY);
+      if(fd < 0){
+        printf(1, "icache: open %s failed\n", nm);
+        exit();
+      }
+      if(k == 0){
+        write(fd, &i, sizeof(i));
+      } else if(read(fd, &n, sizeof(n)) != sizeof(n) || n != i){
+        printf(1, "icache: %s holds the wrong data\n", nm);
+        exit();
+      }
+      close(fd);
+    }
+  }
+  for(i = 0; i < NINODE + 20; i++){
+    nm[1] = '0' + i / 100;
+    nm[2] = '0' + i / 10 % 10;
+    nm[3] = '0' + i % 10;
+    unlink(nm);
+  }
+  printf(1, "icache ok\n");
+}
+
 unsigned long randstate = 1;
 unsigned int
 rand()
@@ -1795,6 +2965,25 @@ main(int argc, char *argv[])
   forktest();
   bigdir(); // slow
 
+  hashdirtest();
+  dcachetest();
+  tracetest();
+  sysstattest();
+  proftest();
+  lockstattest();
+  lockbenchtest();
+  rwbenchtest();
+  uartstattest();
+  stdiotest();
+  malloctest();
+  difftest();
+  stringtest();
+  palindrometest();
+  lseektest();
+  audittest();
+  sessiontest();
+  stattest();
+  icachetest();
   uio();
 
   exectest();
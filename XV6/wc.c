@@ -1,54 +1,228 @@
+// wc [-lwc] [-j jobs] [file ...]
+//
+// Counts lines, words and bytes, or only those asked for.
+// Bytes alone come from fstat for plain files, and lines alone
+// are counted a word at a time; words need the per-byte class
+// table.  With -j, up to that many files are counted at once by
+// child processes that send their counts back through pipes.
+
 #include "types.h"
 #include "stat.h"
 #include "user.h"
+#include "fcntl.h"
+
+#define LINES  1
+#define WORDS  2
+#define BYTES  4
+
+#define SPACE   1             // Class bits in cls[]
+#define NEWLINE 2
+
+#define MAXJOBS 8
 
-char buf[512];
+struct counts {
+  uint l, w, c;
+  int ok;
+};
+
+char buf[65536];
+uchar cls[256];
+int want;
+
+// Newlines in the aligned words [p, p+n).
+static uint
+newlines(uint *p, int n)
+{
+  uint x, z, l;
+
+  l = 0;
+  for(; n > 0; n--, p++){
+    // A zero byte of x is a newline of *p; set its high bit in z.
+    x = *p ^ 0x0a0a0a0a;
+    z = ~(((x & 0x7f7f7f7f) + 0x7f7f7f7f) | x) & 0x80808080;
+    l += ((z >> 7) * 0x01010101) >> 24;
+  }
+  return l;
+}
 
 void
-wc(int fd, char *name)
-{
-  int i, n;
-  int l, w, c, inword;
-
-  l = w = c = 0;
-  inword = 0;
-  while((n = read(fd, buf, sizeof(buf))) > 0){
-    for(i=0; i<n; i++){
-      c++;
-      if(buf[i] == '\n')
-        l++;
-      if(strchr(" \r\t\n\v", buf[i]))
-        inword = 0;
-      else if(!inword){
-        w++;
-        inword = 1;
+count(int fd, struct counts *n)
+{
+  struct stat st;
+  uchar *p, *e;
+  uint k;
+  int m, s, prev;
+
+  n->l = n->w = n->c = 0;
+  n->ok = 1;
+  if(want == BYTES && fstat(fd, &st) == 0 && st.type == T_FILE){
+    n->c = st.size;
+    return;
+  }
+  prev = SPACE;
+  while((m = read(fd, buf, sizeof(buf))) > 0){
+    n->c += m;
+    p = (uchar*)buf;
+    e = p + m;
+    if(want & WORDS){
+      for(; p < e; p++){
+        s = cls[*p];
+        n->w += prev & ~s & SPACE;
+        n->l += s >> 1;
+        prev = s;
       }
+    } else if(want & LINES){
+      k = m / 4;
+      n->l += newlines((uint*)p, k);
+      for(p += 4*k; p < e; p++)
+        n->l += *p == '\n';
     }
   }
-  if(n < 0){
-    printf(1, "wc: read error\n");
+  if(m < 0)
+    n->ok = 0;
+}
+
+void
+print(struct counts *n, char *name)
+{
+  if(want & LINES)
+    printf(1, "%d ", n->l);
+  if(want & WORDS)
+    printf(1, "%d ", n->w);
+  if(want & BYTES)
+    printf(1, "%d ", n->c);
+  printf(1, "%s\n", name);
+}
+
+void
+wc(char *name, struct counts *n)
+{
+  int fd;
+
+  if((fd = open(name, O_RDONLY)) < 0){
+    n->ok = -1;
+    return;
+  }
+  count(fd, n);
+  close(fd);
+}
+
+// Print name's counts, adding them to total.
+void
+report(char *name, struct counts *n, struct counts *total)
+{
+  if(n->ok < 0){
+    printf(2, "wc: cannot open %s\n", name);
+    return;
+  }
+  if(n->ok == 0)
+    printf(2, "wc: read error in %s\n", name);
+  print(n, name);
+  total->l += n->l;
+  total->w += n->w;
+  total->c += n->c;
+}
+
+// Count name in a child; return the read end of the pipe its
+// counts come back on.
+int
+spawn(char *name)
+{
+  struct counts n;
+  int p[2];
+
+  if(pipe(p) < 0){
+    printf(2, "wc: pipe failed\n");
+    exit();
+  }
+  switch(fork()){
+  case -1:
+    printf(2, "wc: fork failed\n");
+    exit();
+  case 0:
+    close(p[0]);
+    wc(name, &n);
+    write(p[1], &n, sizeof(n));
     exit();
   }
-  printf(1, "%d %d %d %s\n", l, w, c, name);
+  close(p[1]);
+  return p[0];
+}
+
+void
+parallel(char **files, int nfiles, int jobs, struct counts *total)
+{
+  struct counts n;
+  int fds[MAXJOBS], started, done;
+
+  started = done = 0;
+  while(done < nfiles){
+    while(started < nfiles && started - done < jobs){
+      fds[started % jobs] = spawn(files[started]);
+      started++;
+    }
+    if(read(fds[done % jobs], &n, sizeof(n)) != sizeof(n))
+      n.ok = -1;
+    close(fds[done % jobs]);
+    wait();
+    report(files[done], &n, total);
+    done++;
+  }
 }
 
 int
 main(int argc, char *argv[])
 {
-  int fd, i;
+  struct counts n, total;
+  int i, jobs, nfiles;
+  char *p;
 
-  if(argc <= 1){
-    wc(0, "");
+  jobs = 1;
+  for(i = 1; i < argc && argv[i][0] == '-' && argv[i][1]; i++){
+    if(strcmp(argv[i], "-j") == 0 && i + 1 < argc){
+      jobs = atoi(argv[++i]);
+      continue;
+    }
+    for(p = argv[i] + 1; *p; p++){
+      if(*p == 'l')
+        want |= LINES;
+      else if(*p == 'w')
+        want |= WORDS;
+      else if(*p == 'c')
+        want |= BYTES;
+      else {
+        printf(2, "usage: wc [-lwc] [-j jobs] [file ...]\n");
+        exit();
+      }
+    }
+  }
+  if(want == 0)
+    want = LINES | WORDS | BYTES;
+  if(jobs < 1)
+    jobs = 1;
+  if(jobs > MAXJOBS)
+    jobs = MAXJOBS;
+  cls[' '] = cls['\r'] = cls['\t'] = cls['\v'] = SPACE;
+  cls['\n'] = SPACE | NEWLINE;
+
+  if(i == argc){
+    count(0, &n);
+    if(!n.ok)
+      printf(2, "wc: read error\n");
+    print(&n, "");
     exit();
   }
 
-  for(i = 1; i < argc; i++){
-    if((fd = open(argv[i], 0)) < 0){
-      printf(1, "wc: cannot open %s\n", argv[i]);
-      exit();
+  memset(&total, 0, sizeof(total));
+  nfiles = argc - i;
+  if(jobs > 1 && nfiles > 1)
+    parallel(argv + i, nfiles, jobs, &total);
+  else
+    for(; i < argc; i++){
+      wc(argv[i], &n);
+      report(argv[i], &n, &total);
     }
-    wc(fd, argv[i]);
-    close(fd);
-  }
+  if(nfiles > 1)
+    print(&total, "total");
   exit();
 }